@@ -10,10 +10,12 @@
 #include <lightwave/core.hpp>
 #include <lightwave/logger.hpp>
 #include <lightwave/math.hpp>
+#include <lightwave/options.hpp>
 #include <lightwave/properties.hpp>
 #include <lightwave/registry.hpp>
 
 // MARK: - utilities
+#include <lightwave/film.hpp>
 #include <lightwave/iterators.hpp>
 #include <lightwave/parallel.hpp>
 #include <lightwave/streaming.hpp>
@@ -23,6 +25,7 @@
 #include <lightwave/bsdf.hpp>
 #include <lightwave/camera.hpp>
 #include <lightwave/emission.hpp>
+#include <lightwave/filter.hpp>
 #include <lightwave/image.hpp>
 #include <lightwave/instance.hpp>
 #include <lightwave/integrator.hpp>
@@ -20,6 +20,11 @@ struct BsdfSample {
     Color weight;
     /// @brief The probability of the sample
     float pdf;
+    /// @brief The relative index of refraction (inside over outside, as seen
+    /// from @c wo ) for samples that pass through the surface, and 1 otherwise.
+    /// Light tracing integrators need it to undo the scaling of radiance at
+    /// refractive interfaces, which does not apply to importance.
+    float eta = 1;
 
     /// @brief Return an invalid sample, used to denote that sampling has
     /// failed.
@@ -42,6 +47,9 @@ struct BsdfEval {
     Color value;
     /// @brief The probability of the sample
     float pdf;
+    /// @brief The relative index of refraction for pairs of directions on
+    /// opposite sides of the surface, and 1 otherwise (see @ref BsdfSample::eta ).
+    float eta = 1;
 
     /// @brief Indicates the the Bsdf is zero for the given pair of directions.
     static BsdfEval invalid() {
@@ -54,35 +62,75 @@ struct BsdfEval {
     bool isInvalid() const { return value == Color(0); }
 };
 
-/// @brief A Bsdf, representing the scattering distribution of a surface.
+/**
+ * @brief A Bsdf, representing the scattering distribution of a surface.
+ *
+ * Queries are answered from a @ref BsdfClosure , which a Bsdf builds once per surface point and outgoing direction
+ * with @ref prepare (e.g., by looking up its textures), so that evaluating several light samples and sampling a
+ * continuation direction at the same point do not repeat that work. @ref Intersection keeps the closure of its
+ * surface point for this purpose. The overloads taking texture coordinates build a closure for a single query.
+ */
 class Bsdf : public Object {
 public:
+    /**
+     * @brief Builds the closure of the Bsdf for a surface point and outgoing direction.
+     * @param uv The texture coordinates of the surface.
+     * @param wo The outgoing direction light is scattered in, pointing away
+     * from the surface, in local coordinates (i.e., the normal is assumed to be [0,0,1]).
+     */
+    virtual void prepare(const Point2 &uv, const Vector &wo, BsdfClosure &closure) const = 0;
+
     /**
      * @brief Evaluates the Bsdf (including the cosine term) for a given pair
      * of directions in local coordinates (i.e., the normal is assumed to be
      * [0,0,1]).
-     * @param uv The texture coordinates of the surface.
+     * @param closure The closure built by @ref prepare for @c wo .
      * @param wo The outgoing direction light is scattered in, pointing away
      * from the surface, in local coordinates.
      * @param wi The incoming direction light comes from, pointing away
      * from the surface, in local coordinates.
      */
-    virtual BsdfEval evaluate(const Point2 &uv, const Vector &wo,
+    virtual BsdfEval evaluate(const BsdfClosure &closure, const Vector &wo,
                               const Vector &wi) const = 0;
     /**
      * @brief Samples a direction according to the distribution of the Bsdf in
      * local coordinates (i.e., the normal is assumed to be [0,0,1]).
      * @note Can also produce invalid samples in case sampling fails (use @ref
      * BsdfSample::isInvalid() to check for this).
-     * @param uv The texture coordinates of the surface.
+     * @param closure The closure built by @ref prepare for @c wo .
      * @param wo The outgoing direction light is scattered in, pointing away
      * from the surface, in local coordinates.
      * @param rng A random number generator used to steer the sampling.
      */
-    virtual BsdfSample sample(const Point2 &uv, const Vector &wo,
+    virtual BsdfSample sample(const BsdfClosure &closure, const Vector &wo,
                               Sampler &rng) const = 0;
 
-    virtual Color albedo(const Point2 &uv, const Vector &wo) const = 0;
+    virtual Color albedo(const BsdfClosure &closure, const Vector &wo) const = 0;
+
+    /// @brief Evaluates the Bsdf for a single pair of directions (see above).
+    BsdfEval evaluate(const Point2 &uv, const Vector &wo,
+                      const Vector &wi) const {
+        BsdfClosure closure;
+        prepare(uv, wo, closure);
+        return evaluate(closure, wo, wi);
+    }
+    /// @brief Samples the Bsdf for a single outgoing direction (see above).
+    BsdfSample sample(const Point2 &uv, const Vector &wo, Sampler &rng) const {
+        BsdfClosure closure;
+        prepare(uv, wo, closure);
+        return sample(closure, wo, rng);
+    }
+    Color albedo(const Point2 &uv, const Vector &wo) const {
+        BsdfClosure closure;
+        prepare(uv, wo, closure);
+        return albedo(closure, wo);
+    }
+
+    /**
+     * @brief Whether the Bsdf is Lambertian, i.e., it scatters @ref albedo divided by pi into all directions of the
+     * upper hemisphere. Integrators can then shade it from the irradiance alone (e.g., using an irradiance cache).
+     */
+    virtual bool isDiffuse() const { return false; }
 };
 
 } // namespace lightwave
@@ -7,6 +7,7 @@
 
 #include <lightwave/core.hpp>
 #include <lightwave/color.hpp>
+#include <lightwave/filter.hpp>
 #include <lightwave/math.hpp>
 #include <lightwave/properties.hpp>
 #include <lightwave/transform.hpp>
@@ -22,6 +23,32 @@ struct CameraSample {
     Color weight;
 };
 
+/// @brief The result of connecting a point in the scene to a Camera using @ref Camera::connect .
+struct CameraConnection {
+    /// @brief The direction vector, pointing from the point towards the camera.
+    Vector wi;
+    /// @brief The importance the camera emits towards the point, divided by the density of connecting to the camera
+    /// (in solid angle as seen from the point).
+    Color weight;
+    /// @brief The distance from the point to the camera.
+    float distance;
+    /// @brief The position on the image the point projects to, in pixels.
+    Point2 pixel;
+
+    /// @brief Return an invalid connection, used to denote that the point is not seen by the camera.
+    static CameraConnection invalid() {
+        return {
+            .wi = Vector(),
+            .weight = Color(0),
+            .distance = 0,
+            .pixel = Point2(0),
+        };
+    }
+
+    /// @brief Tests whether the connection is invalid (i.e., the point is not seen by the camera).
+    bool isInvalid() const { return weight == Color(0); }
+};
+
 /// @brief A Camera, representing the relationship between pixel coordinates and rays.
 class Camera : public Object {
 protected:
@@ -30,21 +57,27 @@ protected:
 
     /// @brief The transform that leads from local coordinates to world space coordinates.
     ref<Transform> m_transform;
+    /// @brief The pixel reconstruction filter camera samples are distributed by (a box over the pixel if not given).
+    ref<Filter> m_filter;
 
 public:
     Camera(const Properties &properties) {
         m_resolution.x() = properties.get<int>("width");
         m_resolution.y() = properties.get<int>("height");
         m_transform = properties.getChild<Transform>();
+        m_filter = properties.getOptionalChild<Filter>();
     }
 
     /// @brief Returns the resolution of the image that is being rendered. 
     const Vector2i &resolution() const { return m_resolution; }
+    /// @brief Returns the pixel reconstruction filter, or nullptr if samples are distributed uniformly over pixels.
+    const Filter *filter() const { return m_filter.get(); }
 
     /**
      * @brief Helper function to sample the camera model for a given pixel.
-     * This function samples a random position within the given pixel, normalizes the pixel coordinates, and
-     * then calls the @c CameraSample::sample method for normalized pixel coordinates.
+     * This function samples a random position within the given pixel (or around it, proportionally to the
+     * reconstruction filter), normalizes the pixel coordinates, and then calls the @c CameraSample::sample method for
+     * normalized pixel coordinates.
      * 
      * @param pixel The pixel coordinates ranging from [0,0] to [resolution().x() - 1, resolution.y() - 1].
      * @param rng A random number generator used to steer the sampling.
@@ -60,6 +93,21 @@ public:
      * @param rng A random number generator used to steer the sampling.
      */
     virtual CameraSample sample(const Point2 &normalized, Sampler &rng) const = 0;
+
+    /// @brief Returns whether points in the scene can be connected to the camera via @ref connect (e.g., for light
+    /// tracing).
+    virtual bool supportsConnections() const { return false; }
+    /**
+     * @brief Connects a point in world space coordinates to the camera, and computes where it ends up on the image.
+     * The importance is normalized such that splatting the weighted contributions of one light path per camera sample
+     * yields the same image as tracing the camera samples.
+     * @param point The point that should be connected to the camera.
+     * @param rng A random number generator used to steer the sampling (e.g., of a position on a lens).
+     */
+    virtual CameraConnection connect(const Point &point, Sampler &rng) const { return CameraConnection::invalid(); }
+    /// @brief Returns the density (in solid angle) of @ref sample producing rays in a given direction in world space
+    /// coordinates, assuming that positions on the image are distributed uniformly.
+    virtual float pdf(const Vector &direction) const { return 0; }
 };
 
 }
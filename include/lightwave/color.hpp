@@ -111,6 +111,11 @@ public:
         return (1 / 3.f) * (r() + g() + b());
     }
 
+    /// @brief Returns the largest component of this color.
+    float maxComponent() const {
+        return std::max(std::max(r(), g()), b());
+    }
+
     /// @brief Creates black color (i.e., all components 0).
     static Color black() { return Color(0); }
     /// @brief Creates white color (i.e., all components 1). 
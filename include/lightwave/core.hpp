@@ -171,6 +171,17 @@ public:
     }
 };
 
+/// @brief Combines a hash with a 64-bit value (using the finalizer of MurmurHash3), e.g. to build keys for caches.
+inline uint64_t hashMix(uint64_t hash, uint64_t value) {
+    hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9a63f5f3c67ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
 /**
  * @brief Converts a given object to a string, and then indents the string by @c amount levels (two spaces each).
  * @note Used for convenience in many @c toString functions of objects.
@@ -24,25 +24,68 @@ struct Sample2D {
     float pdf;
 };
 
+/**
+ * @brief Samples a discrete distribution in constant time using Vose's alias method: every entry owns a bin of equal
+ * probability, which it shares with at most one other entry (its alias) to make up for its own deficit.
+ */
+class AliasTable {
+    struct Bin {
+        /// @brief The normalized probability of the entry.
+        float pdf;
+        /// @brief The probability of picking the entry itself rather than its alias when landing in its bin.
+        float threshold;
+        uint32_t alias;
+    };
+    std::vector<Bin> m_bins;
+
+public:
+    AliasTable() {}
+    /// @brief Builds the table for non-negative weights, which need not be normalized (uniform if all are zero).
+    AliasTable(std::span<const float> weights);
+
+    size_t size() const { return m_bins.size(); }
+    /// @brief Returns the probability of picking a given entry.
+    float pdf(size_t index) const { return m_bins[index].pdf; }
+    /**
+     * @brief Picks an entry using a single uniform random number.
+     * @return The entry, its probability, and the random number remapped to [0,1), which is independent of the choice
+     * and can be reused (e.g., to sample within the entry).
+     */
+    Sample1D sample(float u) const;
+};
+
+/**
+ * @brief Samples a piecewise constant distribution over [0,1) by inverting its CDF.
+ *
+ * The inversion starts from a guide table (Chen and Wu, "Cumulative distribution function-based random variate
+ * generation", 1974): the unit interval is split into as many equal cells as there are entries, and each cell stores the
+ * entry its lower end falls into. Only the few entries spanned by a cell need to be searched, which takes constant time
+ * on average, while still mapping random numbers monotonically (and thus preserving their stratification).
+ */
 class Distribution1D {
-    std::span<float> m_data;
+    std::vector<float> m_data;
     std::vector<float> m_cdf;
+    /// @brief The entry that the lower end of each cell of the guide table falls into.
+    std::vector<uint32_t> m_guide;
     size_t m_size;
     float m_sum;
 
 public:
     Distribution1D();
-    Distribution1D(std::span<float> data);
-    Sample1D sampleContinous(Sampler &rng) const;
+    Distribution1D(std::span<const float> data);
+    /// @brief Samples the distribution, returning the same results as a binary search over the CDF would.
+    Sample1D sampleContinous(float u) const;
+    Sample1D sampleContinous(Sampler &rng) const { return sampleContinous(rng.next()); }
     float sum() const;
 
-    std::span<float> data() const;
+    std::span<const float> data() const;
+    /// @brief Returns the normalized CDF, which has one more element than there are entries.
+    std::span<const float> cdf() const;
 };
 
 class Distribution2D {
     std::vector<Distribution1D> m_conditional;
     Distribution1D m_marginal;
-    std::vector<float> m_marginal_data;
 
     Point2i m_resolution;
 
@@ -51,7 +94,12 @@ public:
     Distribution2D(ScalarImage scalar);
 
     float pdf(Point2 uv) const;
+    /// @brief Samples a row from the marginal distribution (using the second component), then a column within it.
+    Sample2D sampleContinous(Point2 u) const;
     Sample2D sampleContinous(Sampler &rng) const;
+
+    const Distribution1D &marginal() const { return m_marginal; }
+    const Distribution1D &conditional(size_t row) const { return m_conditional[row]; }
 };
 
 }
\ No newline at end of file
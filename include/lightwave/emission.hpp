@@ -37,6 +37,8 @@ public:
      * @param wo The outgoing direction light is emitted in, pointing away from the surface, in local coordinates.
      */
     virtual EmissionEval evaluate(const Point2 &uv, const Vector &wo) const = 0;
+    /// @brief Returns the power emitted per unit area (the radiant exitance), averaged over the surface.
+    virtual Color exitance() const = 0;
 };
 
 }
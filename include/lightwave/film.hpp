@@ -0,0 +1,247 @@
+/**
+ * @file film.hpp
+ * @brief Contains the Film class, which accumulates the samples of an
+ * integrator before they are developed into an image.
+ */
+
+#pragma once
+
+#include <lightwave/color.hpp>
+#include <lightwave/core.hpp>
+#include <lightwave/filter.hpp>
+#include <lightwave/image.hpp>
+#include <lightwave/math.hpp>
+
+#include <array>
+#include <filesystem>
+#include <vector>
+
+namespace lightwave {
+
+/// @brief The running estimate of a single pixel.
+struct PixelEstimate {
+    /// @brief The sum of all sample values taken so far.
+    Color sum;
+    /// @brief The running mean of the sample luminance (Welford's algorithm).
+    float mean = 0;
+    /// @brief The running sum of squared differences from the mean luminance
+    /// (Welford's algorithm).
+    float m2 = 0;
+    /// @brief The number of samples taken so far.
+    int count = 0;
+
+    /// @brief Adds a sample to the estimate.
+    void add(const Color &sample) {
+        const float luminance = sample.luminance();
+        count++;
+        sum += sample;
+        const float delta = luminance - mean;
+        mean += delta / count;
+        m2 += delta * (luminance - mean);
+    }
+
+    /**
+     * @brief Combines the estimate with one obtained from a disjoint set of
+     * samples of the same pixel (Chan et al.'s parallel variant of Welford's
+     * algorithm), e.g., from another process of a distributed render.
+     */
+    void merge(const PixelEstimate &other) {
+        if (!other.count)
+            return;
+        const int total    = count + other.count;
+        const float delta  = other.mean - mean;
+        const float weight = float(other.count) / total;
+        sum += other.sum;
+        mean += delta * weight;
+        m2 += other.m2 + delta * delta * count * weight;
+        count = total;
+    }
+
+    /// @brief Returns the current estimate of the pixel value.
+    Color value() const { return count ? sum / float(count) : Color(); }
+
+    /// @brief Returns the sample variance of the luminance.
+    float variance() const { return count > 1 ? m2 / (count - 1) : 0; }
+
+    /**
+     * @brief Returns the standard error of the mean luminance relative to the
+     * mean luminance itself.
+     * @note The mean is clamped from below so that nearly black pixels do not
+     * absorb the entire sample budget.
+     */
+    float relativeError() const {
+        if (count < 2)
+            return Infinity;
+        return safe_sqrt(variance() / count) / std::max(mean, 1e-2f);
+    }
+};
+
+/**
+ * @brief Accumulates the samples of a sampling integrator per pixel, and keeps
+ * track of how many samples each pixel has received and how noisy it is.
+ */
+class Film {
+    /// @brief The resolution of the film in pixels.
+    Point2i m_resolution;
+    /// @brief The running estimates of all pixels, in scanline order.
+    std::vector<PixelEstimate> m_pixels;
+
+public:
+    Film() {}
+
+    /// @brief Changes the resolution and discards all samples.
+    void initialize(const Point2i &resolution);
+
+    /// @brief Returns the estimate of a given pixel.
+    const PixelEstimate &operator()(const Point2i &pixel) const {
+        return m_pixels[pixel.y() * m_resolution.x() + pixel.x()];
+    }
+    /// @brief Returns a modifiable reference to the estimate of a given pixel.
+    PixelEstimate &operator()(const Point2i &pixel) {
+        return m_pixels[pixel.y() * m_resolution.x() + pixel.x()];
+    }
+
+    /// @brief Returns the resolution of the film in pixels.
+    const Point2i &resolution() const { return m_resolution; }
+    /// @brief Returns the bounding box of the film in pixels.
+    Bounds2i bounds() const { return { {}, Vector2i(m_resolution) }; }
+
+    /// @brief Copies the estimates of the pixels within a block from another
+    /// film of identical resolution.
+    void copy(const Film &other, const Bounds2i &block);
+
+    /**
+     * @brief Merges the estimates of another film of identical resolution,
+     * whose samples are disjoint from the ones of this film.
+     */
+    void merge(const Film &other);
+
+    /**
+     * @brief Writes the pixel estimates within a region, along with the index
+     * of the render pass that was in progress, to a binary file. Such files
+     * serve both as checkpoints and as the partial results of distributed
+     * renders.
+     * @note The file is written under a temporary name and then renamed, so
+     * that an interruption never leaves behind a truncated file.
+     */
+    void save(const std::filesystem::path &path, int pass,
+              const Bounds2i &region) const;
+    /// @brief Writes all pixel estimates to a binary file (see above).
+    void save(const std::filesystem::path &path, int pass) const {
+        save(path, pass, bounds());
+    }
+    /**
+     * @brief Restores the pixel estimates (and the resolution) from a binary
+     * file. Pixels outside of the region that has been saved are left without
+     * samples.
+     * @return The index of the render pass that was in progress.
+     */
+    int load(const std::filesystem::path &path);
+
+    /// @brief Returns the total number of samples taken over all pixels.
+    int64_t totalSamples() const;
+
+    /// @brief Writes the current pixel estimates into an image.
+    void develop(Image &image) const { develop(image, bounds()); }
+    /// @brief Writes the current pixel estimates of a block into an image.
+    void develop(Image &image, const Bounds2i &block) const;
+    /// @brief Writes the number of samples of each pixel into an image.
+    void developSampleCount(Image &image) const;
+    /// @brief Writes the variance of the mean luminance of each pixel into an
+    /// image.
+    void developVariance(Image &image) const;
+};
+
+/**
+ * @brief Accumulates contributions that may land on any pixel (e.g., the
+ * splats of light tracing), without locks and with results that do not depend
+ * on the scheduling of threads.
+ *
+ * Contributions are converted to fixed point and summed into a few tile
+ * buffers owned by each @ref Writer , which are added to the shared sums with
+ * atomic integer additions once a writer runs out of tiles or is flushed. As
+ * integer addition is associative, neither the order of flushes nor the number
+ * of threads affects the result, and contention only arises per tile flush
+ * instead of per contribution.
+ */
+class SplatFilm {
+public:
+    /// @brief The edge length in pixels of the tiles writers buffer.
+    static constexpr int TileSize = 32;
+    /// @brief The number of tiles each writer buffers before flushing.
+    static constexpr int TileCacheSize = 8;
+
+    /// @brief Buffers the contributions of a single thread (or work item).
+    class Writer {
+        struct Tile {
+            /// @brief The index of the tile in the film, or -1 if unused.
+            int index = -1;
+            std::array<int64_t, 3 * TileSize * TileSize> sums;
+        };
+
+        SplatFilm &m_film;
+        std::vector<Tile> m_tiles;
+        /// @brief The tile that is flushed next when a new tile is needed.
+        int m_nextEviction = 0;
+
+        /// @brief Returns the buffered sums of a pixel, which must lie within
+        /// the film.
+        int64_t *sums(const Point2i &pixel);
+        /// @brief Adds a tile buffer to the film and clears it.
+        void flush(Tile &tile);
+
+    public:
+        Writer(SplatFilm &film) : m_film(film), m_tiles(TileCacheSize) {}
+        Writer(const Writer &) = delete;
+        ~Writer() { flush(); }
+
+        /// @brief Adds a contribution to the pixel that contains a position
+        /// (in pixels), or, if a filter is given, to all pixels within its
+        /// radius weighted by the filter. Positions outside the film are
+        /// ignored.
+        void splat(const Point2 &position, const Color &value,
+                   const Filter *filter = nullptr);
+        /// @brief Adds all buffered contributions to the film.
+        void flush();
+    };
+
+    SplatFilm() {}
+
+    /// @brief Changes the resolution and discards all contributions.
+    void initialize(const Point2i &resolution);
+
+    /// @brief Returns the resolution of the film in pixels.
+    const Point2i &resolution() const { return m_resolution; }
+
+    /// @brief Returns the sum of all flushed contributions to a pixel.
+    Color operator()(const Point2i &pixel) const;
+
+    /// @brief Writes the sums of all pixels, multiplied by a given scale (e.g.,
+    /// the inverse number of samples), into an image.
+    void develop(Image &image, float scale = 1) const;
+
+private:
+    /// @brief The scale of the fixed-point representation of contributions,
+    /// leaving 32 bits for integer and fraction each.
+    static constexpr double FixedPointScale = 4294967296.0;
+
+    Point2i m_resolution;
+    Vector2i m_tileCount;
+    /// @brief The fixed-point sums of all pixels, in tile order and with three
+    /// channels per pixel.
+    std::vector<int64_t> m_sums;
+
+    /// @brief Returns the offset of the sums of a pixel in @ref m_sums .
+    size_t offset(const Point2i &pixel) const {
+        const int tile = (pixel.y() / TileSize) * m_tileCount.x() +
+                         pixel.x() / TileSize;
+        const int local =
+            (pixel.y() % TileSize) * TileSize + pixel.x() % TileSize;
+        return 3 * (size_t(tile) * TileSize * TileSize + local);
+    }
+
+    /// @brief Converts a contribution to fixed point, saturating on overflow.
+    static int64_t toFixedPoint(float value);
+};
+
+} // namespace lightwave
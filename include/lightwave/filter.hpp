@@ -0,0 +1,40 @@
+/**
+ * @file filter.hpp
+ * @brief Contains the Filter interface, used to reconstruct pixel values from
+ * samples.
+ */
+
+#pragma once
+
+#include <lightwave/core.hpp>
+#include <lightwave/math.hpp>
+
+namespace lightwave {
+
+/**
+ * @brief A pixel reconstruction filter, which determines how much a sample
+ * contributes to the pixels around it. Filters are normalized (i.e., integrate
+ * to one over the plane) and non-negative, so that camera samples can be
+ * importance sampled from them with a constant weight of one.
+ */
+class Filter : public Object {
+public:
+    Filter() {}
+
+    /// @brief Returns the distance from the pixel center (in pixels) beyond
+    /// which the filter is zero along each axis.
+    virtual float radius() const = 0;
+
+    /// @brief Evaluates the filter for an offset from the pixel center (in
+    /// pixels).
+    virtual float evaluate(const Vector2 &offset) const = 0;
+
+    /**
+     * @brief Samples an offset from the pixel center (in pixels) proportionally
+     * to the filter.
+     * @param rnd A uniformly distributed point in [0,1]^2.
+     */
+    virtual Vector2 sample(const Point2 &rnd) const = 0;
+};
+
+} // namespace lightwave
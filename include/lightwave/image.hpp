@@ -65,6 +65,10 @@ public:
         m_basePath = basePath;
     }
 
+    /// @brief Returns the folder the image will be stored in if no explicit
+    /// path is given.
+    const std::filesystem::path &basePath() const { return m_basePath; }
+
     /// @brief Copies the data and resolution from another image, but leaves all
     /// other attributes the same.
     void copy(const Image &image) {
@@ -177,6 +181,9 @@ public:
         }
     }
 
+    /// @brief Returns a hash of the resolution and pixels of this image.
+    uint64_t hash() const;
+
     /// @brief Returns the number of bytes used to store a single pixel.
     int getBytesPerPixel() const { return sizeof(Color); }
 
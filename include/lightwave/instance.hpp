@@ -38,6 +38,8 @@ class Instance : public Shape {
     
     /// @brief Transforms the frame from object coordinates to world coordinates.
     inline void transformFrame(SurfaceEvent &surf) const;
+    /// @brief Intersects the wrapped shape, or only one of its primitives if @c primitive is not negative.
+    inline bool intersectShape(int primitive, const Ray &worldRay, Intersection &its, Sampler &rng) const;
 
 public:
     Instance(const Properties &properties) 
@@ -85,6 +87,8 @@ public:
      * @return @c true if an intersection was found.
      */
     bool intersect(const Ray &ray, Intersection &its, Sampler &rng) const override;
+    /// @brief Intersects a single primitive of the wrapped shape with a given ray in world coordinates (see above).
+    bool intersectPrimitive(int primitive, const Ray &ray, Intersection &its, Sampler &rng) const override;
     /// @brief Returns the bounding box of the instance in world coordinates. 
     Bounds getBoundingBox() const override;
     /// @brief Returns the centroid of the instance in world coordinates. 
@@ -94,6 +98,17 @@ public:
      * @param rng A random number generator used to steer sampling decisions.
      */
     AreaSample sampleArea(const Point &reference, Sampler &rng) const override;
+    /// @brief Samples a point in world coordinates uniformly over the surface of the wrapped shape.
+    AreaSample sampleSurface(Sampler &rng) const override;
+    /**
+     * @brief Returns the surface area of the instance in world coordinates.
+     * @note The transform of an enclosing instance is only used if this instance has no transform of its own.
+     */
+    float area(const Transform *transform) const override {
+        return m_shape->area(m_transform ? m_transform.get() : transform);
+    }
+    /// @brief Returns a cone that contains all surface normals of the instance in world coordinates.
+    DirectionCone normalBounds() const override;
 
     /// @brief Returns a textual representation of this image.
     std::string toString() const override {
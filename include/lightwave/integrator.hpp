@@ -7,9 +7,11 @@
 
 #include <lightwave/core.hpp>
 #include <lightwave/color.hpp>
+#include <lightwave/film.hpp>
 #include <lightwave/math.hpp>
 #include <lightwave/sampler.hpp>
 #include <lightwave/image.hpp>
+#include <lightwave/options.hpp>
 #include <lightwave/scene.hpp>
 
 namespace lightwave {
@@ -37,6 +39,99 @@ protected:
     ref<Image> m_image;
     /// @brief The scene that should be rendered.
     ref<Scene> m_scene;
+    /// @brief The per-pixel sample accumulation the output image is developed from.
+    Film m_film;
+
+    /**
+     * @brief Whether to distribute samples adaptively. If enabled, the sample count of the sampler acts as upper
+     * bound, and pixels stop receiving samples once their relative error drops below @ref m_adaptiveThreshold .
+     */
+    bool m_adaptive;
+    /// @brief The relative standard error of a pixel below which adaptive sampling considers it converged.
+    float m_adaptiveThreshold;
+    /// @brief The number of samples every pixel receives before adaptive sampling starts.
+    int m_adaptiveMinCount;
+    /// @brief The number of samples added to each unconverged pixel per adaptive pass.
+    int m_adaptiveBatch;
+    /// @brief An optional image that receives the number of samples taken per pixel.
+    ref<Image> m_sampleCount;
+    /// @brief An optional image that receives the variance of the value of each pixel (i.e., of its mean luminance).
+    ref<Image> m_variance;
+
+    /**
+     * @name Auxiliary outputs
+     * Optional images that receive the average properties of the first surface seen by the camera rays of each pixel
+     * (e.g., as feature buffers for denoising). They are recorded from the same camera rays as the rendered image, so
+     * that all buffers of a render agree, and are saved together with it.
+     * @note Buffers only cover samples taken by the current process, and are not written by partial renders.
+     */
+    /// @{
+    /// @brief The albedo of surfaces, the emission of light sources and the background for rays that escape.
+    ref<Image> m_albedo;
+    /// @brief The world-space shading normal of surfaces (zero for rays that escape).
+    ref<Image> m_normals;
+    /// @brief The distance of surfaces along camera rays (zero for rays that escape).
+    ref<Image> m_distance;
+    /// @brief The world-space position of surfaces (zero for rays that escape).
+    ref<Image> m_position;
+    /// @brief The number of samples that contributed to the auxiliary outputs of each pixel, in scanline order.
+    std::vector<int> m_auxiliaryCount;
+    /// @}
+
+    /// @brief The number of samples per pixel taken in each render pass before adaptive sampling starts.
+    int m_passSize;
+    /// @brief The number of seconds between checkpoints of the render progress (0 disables checkpointing).
+    float m_checkpointInterval;
+
+    /**
+     * @brief The edge length in pixels of the tiles adaptive sampling makes its decisions for.
+     * Pooling the error over a tile avoids that pixels whose first few samples happen to agree (e.g., because all of
+     * them missed a small light source) are considered converged, which would bias the result.
+     */
+    static constexpr int AdaptiveTileSize = 8;
+
+    /// @brief Reports whether adaptive sampling should stop sampling the pixels of a given tile.
+    bool hasConverged(const Bounds2i &tile) const;
+
+    /// @brief Whether any auxiliary output has been requested.
+    bool hasAuxiliaryOutputs() const { return m_albedo || m_normals || m_distance || m_position; }
+
+    /**
+     * @brief Adds the first surface hit by a camera ray to the auxiliary outputs of a pixel, if any have been
+     * requested. This is called after the ray has been traced, so that the rendered image does not depend on which
+     * outputs are requested.
+     */
+    void recordAuxiliaryOutputs(const Point2i &pixel, const Ray &ray, Sampler &rng);
+
+    /**
+     * @brief Takes samples for each pixel of a block until it has reached a total of @c target samples, continuing
+     * the sample sequence of each pixel where the previous pass stopped (offset by the first sample index of
+     * @ref Options::sampleOffset ). If @c skipConverged is set, converged tiles are left untouched.
+     * @note As the sample target is absolute, rendering a block for the same pass twice is harmless, which allows
+     * resuming from checkpoints in which only some blocks have completed the pass that was in progress.
+     * @return The number of samples that have been taken.
+     * @note Integrators that do not trace paths one at a time (e.g., wavefront integrators) can override this method,
+     * and thereby still benefit from adaptive sampling, checkpointing and distributed rendering.
+     */
+    virtual int renderBlock(const Bounds2i &block, Sampler &sampler, int target, bool skipConverged);
+
+    /**
+     * @brief Called once all samples have been taken, right before the image is saved. Integrators can override this
+     * to add contributions that are not accumulated per pixel in @ref m_film (e.g., the splats of light tracing).
+     */
+    virtual void finishImage() {}
+
+    /**
+     * @brief Returns the path of the output image without its extension. Partial renders carry the name of their
+     * slice, so that several processes of a distributed render can share a directory.
+     */
+    std::filesystem::path outputStem() const {
+        return m_image->basePath() / (options.partial.empty() ? m_image->id() : m_image->id() + "." + options.partial);
+    }
+    /// @brief Returns the file that checkpoints of the render progress are written to.
+    std::filesystem::path checkpointPath() const { return outputStem() += ".checkpoint"; }
+    /// @brief Returns the file that the sample accumulation of partial renders is written to.
+    std::filesystem::path partialPath() const { return outputStem() += ".partial"; }
 
 public:
     SamplingIntegrator(const Properties &properties)
@@ -44,6 +139,23 @@ public:
         m_sampler = properties.getChild<Sampler>();
         m_image = properties.getOptionalChild<Image>();
         m_scene = properties.getChild<Scene>();
+
+        m_adaptive = properties.get<bool>("adaptive", false);
+        m_adaptiveThreshold = properties.get<float>("adaptiveThreshold", 0.02f);
+        m_adaptiveMinCount = std::min(std::max(properties.get<int>("adaptiveMinCount", 16), 2),
+                                      m_sampler->samplesPerPixel());
+        m_adaptiveBatch = std::max(properties.get<int>("adaptiveBatch", 8), 1);
+        m_sampleCount = properties.get<Image>("sampleCount", nullptr);
+        m_variance = properties.get<Image>("variance", nullptr);
+        m_albedo = properties.get<Image>("albedo", nullptr);
+        m_normals = properties.get<Image>("normals", nullptr);
+        // "depth" already denotes the path length of most integrators
+        m_distance = properties.get<Image>("distance", nullptr);
+        m_position = properties.get<Image>("position", nullptr);
+
+        m_checkpointInterval = properties.get<float>("checkpointInterval", options.checkpointInterval);
+        // checkpoints can only be taken between passes of a block, hence keep passes short when checkpointing
+        m_passSize = std::max(properties.get<int>("passSize", m_checkpointInterval > 0 ? 16 : m_sampler->samplesPerPixel()), 1);
     }
 
     /// @brief Sets the output image that should be populated by rendering.
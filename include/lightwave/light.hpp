@@ -9,6 +9,8 @@
 #include <lightwave/core.hpp>
 #include <lightwave/math.hpp>
 
+#include <optional>
+
 namespace lightwave {
 
 /// @brief The result of sampling a light from a given query point using @ref Light::sampleDirect .
@@ -39,6 +41,51 @@ struct DirectLightSample {
     bool isInvalid() const { return weight == Color(0); }
 };
 
+/// @brief The result of sampling a ray leaving a light source using @ref Light::sampleEmission .
+struct EmissionSample {
+    /// @brief The sampled point on the light source (of which only the position is meaningful for point lights).
+    SurfaceEvent surface;
+    /// @brief The direction light is emitted in, pointing away from the light source.
+    Vector direction;
+    /// @brief The weight of the sample, given by @code Le(direction) * cos(theta) / (p(surface) * p(direction)) @endcode
+    Color weight;
+    /// @brief The probability of the direction, in solid angle.
+    float pdfDirection;
+
+    /// @brief Return an invalid sample, used to denote that sampling has failed.
+    static EmissionSample invalid() {
+        return {
+            .surface = SurfaceEvent{},
+            .direction = Vector(),
+            .weight = Color(0),
+            .pdfDirection = 0,
+        };
+    }
+
+    /// @brief Tests whether the sample is invalid (i.e., sampling has failed).
+    bool isInvalid() const { return weight == Color(0); }
+};
+
+/// @brief The densities with which @ref Light::sampleEmission produces a point and direction.
+struct EmissionPdf {
+    /// @brief The density of the point, in area (1 for lights that are a single point).
+    float position;
+    /// @brief The density of the direction, in solid angle.
+    float direction;
+};
+
+/// @brief Bounds the positions and emission directions of a light source, used to build light trees.
+struct LightBounds {
+    /// @brief The bounding box of all emitting points.
+    Bounds bounds;
+    /// @brief A cone that contains the surface normals of all emitting points.
+    DirectionCone normals;
+    /// @brief The cosine of the angle beyond the normals light is emitted at (zero for lambertian emission).
+    float cosThetaE;
+    /// @brief Whether light is emitted on both sides of the surface.
+    bool twoSided;
+};
+
 /**
  * @brief A light source that can be sampled for direct connections.
  * Some light sources can also be intersected by rays (e.g., area lights or the background light),
@@ -56,6 +103,36 @@ public:
 
     /// @brief Returns whether this light source can be hit by rays (i.e., has an area that has been placed within the scene).
     virtual bool canBeIntersected() const = 0;
+
+    /**
+     * @brief Returns an estimate of the total power emitted by the light source, which is used to pick light sources
+     * proportionally to their contribution.
+     * @param sceneBounds The bounds of the scene geometry, which determine how much power of infinitely distant light
+     * sources reaches the scene.
+     */
+    virtual Color power(const Bounds &sceneBounds) const = 0;
+
+    /**
+     * @brief Returns bounds on the positions and emission directions of the light source, or nothing for light
+     * sources that are infinitely far away (which light trees leave to be sampled separately).
+     */
+    virtual std::optional<LightBounds> bounds() const { return std::nullopt; }
+
+    /// @brief Returns whether paths can be started at the light source via @ref sampleEmission (e.g., for
+    /// bidirectional path tracing).
+    virtual bool supportsEmissionSampling() const { return false; }
+    /**
+     * @brief Samples a random point on the light source and a direction light is emitted in from there.
+     * @param rng A random number generator used to steer the sampling.
+     */
+    virtual EmissionSample sampleEmission(Sampler &rng) const { return EmissionSample::invalid(); }
+    /**
+     * @brief Evaluates the radiance (or intensity, for point lights) emitted from a point on the light source in a
+     * given direction, not including any cosine term.
+     */
+    virtual Color evaluateEmission(const SurfaceEvent &surface, const Vector &direction) const { return Color(0); }
+    /// @brief Returns the densities of @ref sampleEmission producing a given point on the light source and direction.
+    virtual EmissionPdf pdfEmission(const SurfaceEvent &surface, const Vector &direction) const { return { 0, 0 }; }
 };
 
 /// @brief The result of evaluating a @ref BackgroundLight for a incident direction.
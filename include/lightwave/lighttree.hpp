@@ -0,0 +1,86 @@
+/**
+ * @file lighttree.hpp
+ * @brief Contains the LightTree class, which picks light sources according to their contribution to a given point.
+ */
+
+#pragma once
+
+#include <lightwave/core.hpp>
+#include <lightwave/light.hpp>
+#include <lightwave/math.hpp>
+
+#include <unordered_map>
+#include <vector>
+
+namespace lightwave {
+
+/**
+ * @brief A bounding volume hierarchy over light sources, whose nodes bound the positions, emission directions and
+ * total power of all light sources below them (Conty Estevez and Kulla, "Importance Sampling of Many Lights with
+ * Adaptive Tree Splitting", 2018, in the variant of pbrt-v4).
+ *
+ * A light source is picked by descending from the root, choosing each child proportionally to a conservative estimate
+ * of how much light it contributes to the query point. As each leaf holds a single light source, the probability of
+ * picking it is the product of the probabilities along its path, which can be recomputed for MIS.
+ */
+class LightTree {
+    /// @brief The datatype used to index nodes.
+    typedef int32_t NodeIndex;
+
+    /// @brief A node in our binary tree, laid out like the nodes of @ref AccelerationStructure .
+    struct Node {
+        /// @brief The bounds of all light sources below this node.
+        LightBounds bounds;
+        /// @brief The total power of all light sources below this node.
+        float power;
+        /**
+         * @brief Either the index of the left child node in m_nodes (for internal nodes), or the index of the light
+         * source in m_lights (for leaf nodes).
+         * @note The right child always directly follows the left child.
+         */
+        NodeIndex leftFirst;
+        /// @brief The parent node, or -1 for the root.
+        NodeIndex parent;
+        bool leaf;
+    };
+
+    /// @brief A light source to be placed in the tree.
+    struct Primitive {
+        const Light *light;
+        LightBounds bounds;
+        float power;
+    };
+
+    std::vector<Node> m_nodes;
+    std::vector<const Light *> m_lights;
+    /// @brief The leaf node of each light source, to compute selection probabilities.
+    std::unordered_map<const Light *, NodeIndex> m_leaves;
+
+    /// @brief Estimates how much light the light sources below a node contribute to a given point.
+    float importance(const Node &node, const Point &origin) const;
+    /// @brief Builds the subtree rooted at a given (already allocated) node for a range of primitives.
+    void build(NodeIndex index, std::vector<Primitive> &primitives, size_t begin, size_t end);
+
+public:
+    LightTree() {}
+    /**
+     * @brief Builds the tree over all bounded light sources of a given list.
+     * @param sceneBounds The bounds of the scene, used to estimate the power of the light sources.
+     */
+    LightTree(const std::vector<ref<Light>> &lights, const Bounds &sceneBounds);
+
+    /// @brief Returns whether the tree contains no light sources.
+    bool empty() const { return m_nodes.empty(); }
+    /// @brief Returns whether a light source is part of the tree.
+    bool contains(const Light *light) const { return m_leaves.contains(light); }
+
+    /**
+     * @brief Picks a light source for a given query point using a single uniform random number.
+     * @return The light source (or null if none of them can contribute), and its probability in @c pdf .
+     */
+    const Light *sample(const Point &origin, float u, float &pdf) const;
+    /// @brief Returns the probability of picking a given light source via @ref sample .
+    float pdf(const Light *light, const Point &origin) const;
+};
+
+}
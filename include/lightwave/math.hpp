@@ -11,7 +11,10 @@
 #include <cmath>
 #include <algorithm>
 #include <array>
+#include <cstddef>
+#include <new>
 #include <optional>
+#include <type_traits>
 
 namespace lightwave {
 
@@ -37,6 +40,9 @@ static constexpr float Deg2Rad = Pi / 180.0f;
 /// @brief Multiply by this constant to convert radians into degrees.
 static constexpr float Rad2Deg = 180.0f * InvPi;
 
+/// @brief The largest float below one, used to keep random numbers within [0,1).
+static constexpr float OneMinusEpsilon = 0x1.fffffep-1f;
+
 /**
  * @brief The tolerance threshold for floating point inaccuracies.
  * @example When starting a ray at a surface, it can happen that the surface reports a self-intersection.
@@ -696,6 +702,15 @@ struct Frame {
     }
 };
 
+/// @brief A cone of directions, given by its central axis and the cosine of its half opening angle.
+struct DirectionCone {
+    Vector axis;
+    float cosTheta;
+
+    /// @brief Returns a cone that contains all directions.
+    static DirectionCone all() { return { Vector(0, 0, 1), -1 }; }
+};
+
 /// @brief Barycentric interpolation ([0,0] returns a, [1,0] returns b, and [0,1] returns c).
 template<typename T>
 static T interpolateBarycentric(const Vector2 &bary, const T &a, const T &b, const T &c) {
@@ -740,12 +755,40 @@ struct SurfaceEvent {
     /// @brief The instance object associated with the surface.
     const Instance *instance = nullptr;
 };
+/**
+ * @brief The state of a Bsdf for a given surface point and outgoing direction (e.g., its texture lookups and the
+ * selection probabilities of its lobes), as built by @ref Bsdf::prepare . All evaluations and samples of the Bsdf at
+ * that point can then share this work. Each Bsdf stores a small structure of its own choosing in the closure.
+ */
+class BsdfClosure {
+    /// @brief The largest structure a Bsdf can store in a closure, in bytes.
+    static constexpr size_t Capacity = 48;
+    alignas(16) std::byte m_storage[Capacity];
+
+public:
+    /// @brief Stores the state of a Bsdf, replacing whatever the closure held before.
+    template<typename T>
+    void set(const T &state) {
+        static_assert(sizeof(T) <= Capacity && alignof(T) <= 16, "Bsdf state does not fit into closure");
+        static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>,
+                      "Bsdf state must be trivially copyable");
+        new (m_storage) T(state);
+    }
+
+    /// @brief Returns the state of a Bsdf, which must be of the type that has been stored.
+    template<typename T>
+    const T &get() const { return *std::launder(reinterpret_cast<const T *>(m_storage)); }
+};
+
 /// @brief Describes an intersection of a ray with a surface.
 struct Intersection : public SurfaceEvent {
     /// @brief The direction of the ray that hit the surface, pointing away from the surface.
     Vector wo;
     /// @brief The intersection distance, which can also be used to specify a maximum distance when querying intersections.
     float t;
+    /// @brief The index of the primitive that has been hit within its shape (e.g., the triangle of a mesh), or -1 for
+    /// shapes that do not consist of several primitives.
+    int primitive = -1;
 
     /// @brief Statistics recorded while traversing acceleration structures.
     struct {
@@ -774,6 +817,16 @@ struct Intersection : public SurfaceEvent {
     BsdfEval evaluateBsdf(const Vector &wi) const;
 
     Color evaluateAlbedo() const;
+
+private:
+    /// @brief The closure of the Bsdf for @ref wo , which is built by the first query of the Bsdf and shared by all
+    /// later ones (e.g., the light samples and the BSDF sample of a path vertex).
+    mutable BsdfClosure m_bsdfClosure;
+    /// @brief Whether @ref m_bsdfClosure has been built.
+    mutable bool m_hasBsdfClosure = false;
+
+    /// @brief Returns the closure of the Bsdf, building it if needed.
+    const BsdfClosure &bsdfClosure() const;
 };
 
 /// @brief Print a given point to an output stream.
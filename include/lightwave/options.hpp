@@ -0,0 +1,47 @@
+/**
+ * @file options.hpp
+ * @brief Contains the options that can be passed to lightwave on the command line.
+ */
+
+#pragma once
+
+#include <lightwave/core.hpp>
+#include <lightwave/math.hpp>
+
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+namespace lightwave {
+
+/// @brief Options specified on the command line, which apply to all executables of a scene.
+struct Options {
+    /// @brief Whether sampling integrators should continue from their checkpoints instead of starting from scratch.
+    bool resume = false;
+    /// @brief The default number of seconds between checkpoints of sampling integrators (0 disables checkpointing).
+    float checkpointInterval = 0;
+
+    /// @brief The pixels sampling integrators render, if only part of the image is rendered (e.g., by one process of
+    /// a distributed render).
+    std::optional<Bounds2i> region;
+    /// @brief The index of the first sample sampling integrators take per pixel.
+    int sampleOffset = 0;
+    /// @brief The number of samples sampling integrators take per pixel (0 uses the count of their sampler).
+    int sampleCount = 0;
+    /**
+     * @brief If not empty, sampling integrators write their per-pixel sample accumulation to a partial file carrying
+     * this name instead of saving their image, so that the partial renders of several processes can be merged later.
+     */
+    std::string partial;
+};
+
+/// @brief The options lightwave has been invoked with.
+extern Options options;
+
+/**
+ * @brief Parses the arguments of a render job, i.e., the path of a scene file and the options that apply to it.
+ * @return The path of the scene file, which is empty if none has been specified.
+ */
+std::filesystem::path parseArguments(const std::vector<std::string> &arguments, Options &options);
+
+}
@@ -19,12 +19,20 @@
 
 namespace lightwave {
 
-/// @brief Invokes @c f for each element of the iterator, parallelized across
-/// all available cores.
-template <class ForwardIt, class UnaryFunction>
-void for_each_parallel(ForwardIt first, ForwardIt last, UnaryFunction f) {
+/**
+ * @brief Invokes @c f for each element of the iterator, parallelized across
+ * all available cores. Each thread creates a state object by invoking @c init
+ * once, which it keeps on its stack and passes to @c f along with each element
+ * (e.g., to re-use a sampler across work items instead of allocating one per
+ * work item).
+ */
+template <class ForwardIt, class Init, class BinaryFunction>
+void for_each_parallel(ForwardIt first, ForwardIt last, Init init,
+                       BinaryFunction f) {
 #ifdef SINGLE_THREADED
-    std::for_each(first, last, f);
+    auto state = init();
+    for (; first != last; ++first)
+        f(*first, state);
     return;
 #endif
 
@@ -37,6 +45,7 @@ void for_each_parallel(ForwardIt first, ForwardIt last, UnaryFunction f) {
     // build a thread pool
     for (int i = 0; i < numThreads; i++) {
         m_threads.emplace_back([&]() {
+            auto state = init();
             while (true) {
                 m_lock.lock();
                 if (!(first != last)) {
@@ -51,7 +60,7 @@ void for_each_parallel(ForwardIt first, ForwardIt last, UnaryFunction f) {
                 m_lock.unlock();
 
                 // execute the work item
-                f(obj);
+                f(obj, state);
             }
         });
     }
@@ -61,6 +70,16 @@ void for_each_parallel(ForwardIt first, ForwardIt last, UnaryFunction f) {
         thread.join();
 }
 
+/// @brief Invokes @c f for each element of the iterator, parallelized across
+/// all available cores.
+template <class ForwardIt, class UnaryFunction>
+void for_each_parallel(ForwardIt first, ForwardIt last, UnaryFunction f) {
+    struct NoState {};
+    for_each_parallel(
+        first, last, [] { return NoState(); },
+        [&](auto obj, NoState &) { f(obj); });
+}
+
 /// @brief Invokes @c f for each element of the iterator, parallelized across
 /// all available cores.
 template <class Iterator, class UnaryFunction>
@@ -68,6 +87,13 @@ void for_each_parallel(Iterator it, UnaryFunction f) {
     for_each_parallel(it.begin(), it.end(), f);
 }
 
+/// @brief Invokes @c f for each element of the iterator along with a state
+/// object per thread, parallelized across all available cores.
+template <class Iterator, class Init, class BinaryFunction>
+void for_each_parallel(Iterator it, Init init, BinaryFunction f) {
+    for_each_parallel(it.begin(), it.end(), init, f);
+}
+
 /// @brief Atomically increment a floating point number.
 inline float atomicAdd(float &dst, float delta) {
 #if defined(__clang__)
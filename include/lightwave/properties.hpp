@@ -122,6 +122,14 @@ public:
         }
     }
 
+    /// @brief Suppresses the warnings about attributes and children that have
+    /// not been queried, e.g., when the object has been taken from a cache
+    /// instead of being constructed from these properties.
+    void markAsQueried() const {
+        m_unqueriedAttributes.clear();
+        m_unqueriedChildren.clear();
+    }
+
     /// @brief Checks whether a given attribute is present.
     bool has(const std::string &name) const {
         return m_attributes.find(name) != m_attributes.end();
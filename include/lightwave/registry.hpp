@@ -57,6 +57,7 @@ private:
 #define REGISTER_CAMERA(    Class, Name) REGISTER_CLASS(Class, "camera"    , Name)
 #define REGISTER_SHAPE(     Class, Name) REGISTER_CLASS(Class, "shape"     , Name)
 #define REGISTER_EMISSION(  Class, Name) REGISTER_CLASS(Class, "emission"  , Name)
+#define REGISTER_FILTER(    Class, Name) REGISTER_CLASS(Class, "filter"    , Name)
 #define REGISTER_SAMPLER(   Class, Name) REGISTER_CLASS(Class, "sampler"   , Name)
 #define REGISTER_TRANSFORM( Class, Name) REGISTER_CLASS(Class, "transform" , Name)
 #define REGISTER_INTEGRATOR(Class, Name) REGISTER_CLASS(Class, "integrator", Name)
@@ -9,6 +9,8 @@
 #include <lightwave/math.hpp>
 #include <lightwave/properties.hpp>
 
+#include <array>
+
 namespace lightwave {
 
 /**
@@ -18,10 +20,31 @@ namespace lightwave {
  * by avoiding placing samples close to previous samples.
  */
 class Sampler : public Object {
+public:
+    /**
+     * @brief The number of dimensions samplers generate at once.
+     * Random numbers are consumed through the non-virtual @ref next , which can be inlined into the code of BSDFs,
+     * lights and integrators and only invokes the (virtual) sampler implementation once per batch of dimensions.
+     */
+    static constexpr int BatchSize = 4;
+
+private:
+    /// @brief The dimensions of the current batch that have been generated by the sampler implementation.
+    std::array<float, BatchSize> m_batch;
+    /// @brief The position of the next dimension within the current batch.
+    int m_batchPosition = BatchSize;
+
 protected:
     /// @brief The number of samples that should be taken per pixel.
     int m_samplesPerPixel;
 
+    /// @brief Generates the next @ref BatchSize dimensions of the current random number sequence.
+    virtual void generate(float *values) = 0;
+    /// @brief Initiates the random number sequence for @ref seed(int) .
+    virtual void start(int index) = 0;
+    /// @brief Initiates the random number sequence for @ref seed(const Point2i &, int) .
+    virtual void start(const Point2i &pixel, int sampleIndex) = 0;
+
 public:
     Sampler() : m_samplesPerPixel(0) {}
     Sampler(const Properties &properties) {
@@ -29,10 +52,17 @@ public:
     }
 
     /// @brief Generates a single random number in the interval [0,1). 
-    virtual float next() = 0;
+    float next() {
+        if (m_batchPosition == BatchSize) {
+            generate(m_batch.data());
+            m_batchPosition = 0;
+        }
+        return m_batch[m_batchPosition++];
+    }
     /// @brief Generates a random point in the unit square [0,1)^2. 
-    virtual Point2 next2D() {
-        return { next(), next() };
+    Point2 next2D() {
+        const float x = next();
+        return { x, next() };
     }
 
     /**
@@ -40,13 +70,19 @@ public:
      * @note When identical samplers are given the same seed, they are expected to produce the same sequence
      * of random numbers. For different seeds, they are expected to give different random sequences.
      */
-    virtual void seed(int index) = 0;
+    void seed(int index) {
+        m_batchPosition = BatchSize;
+        start(index);
+    }
     /**
      * @brief Initiates a random number sequence characterized for the given pixel and sample per pixel index.
      * @note When identical samplers are given the same seed, they are expected to produce the same sequence
      * of random numbers. For different seeds, they are expected to give different random sequences.
      */
-    virtual void seed(const Point2i &pixel, int sampleIndex) = 0;
+    void seed(const Point2i &pixel, int sampleIndex) {
+        m_batchPosition = BatchSize;
+        start(pixel, sampleIndex);
+    }
     /// @brief Returns an identical copy of the sampler, e.g., for use in different threads. 
     virtual ref<Sampler> clone() const = 0;
 
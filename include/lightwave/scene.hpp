@@ -6,6 +6,12 @@
 #pragma once
 
 #include <lightwave/core.hpp>
+#include <lightwave/distribution.hpp>
+#include <lightwave/lighttree.hpp>
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace lightwave {
@@ -16,6 +22,23 @@ struct LightSample {
     const Light *light;
     /// @brief The probability of this light source having been picked.
     float probability;
+
+    /// @brief Tests whether the sample is invalid (i.e., no light source can contribute to the query point).
+    bool isInvalid() const { return !light; }
+};
+
+/// @brief Counts how many shadow rays have been answered by the occluder cache of a scene (see @ref Scene::intersect ).
+struct OccluderCacheStatistics {
+    /// @brief The number of shadow rays that were tested towards a known light source.
+    uint64_t rays = 0;
+    /// @brief The number of those shadow rays that turned out to be occluded.
+    uint64_t occluded = 0;
+    /// @brief The number of occluded shadow rays whose occluder was found in the cache, skipping the full traversal.
+    uint64_t hits = 0;
+
+    OccluderCacheStatistics operator-(const OccluderCacheStatistics &other) const {
+        return { rays - other.rays, occluded - other.occluded, hits - other.hits };
+    }
 };
 
 /// @brief Scenes are the input to rendering algorithms: They contain all geometry, materials, lights and the camera.
@@ -31,6 +54,46 @@ class Scene final: public Object {
      * @note Emissive objects will only be part of this list if explicitly requested (i.e., an AreaLight has been created for them).
      */
     std::vector<ref<Light>> m_lights;
+    /// @brief Picks light sources proportionally to their estimated power (or uniformly, if requested).
+    AliasTable m_lightSelection;
+    /// @brief The position of each light source in @ref m_lights , to look up selection probabilities.
+    std::unordered_map<const Light *, size_t> m_lightIndices;
+    /**
+     * @brief Picks light sources according to their contribution to the query point, if requested. Light sources that
+     * are infinitely far away are then picked uniformly among themselves, and as a group as often as the tree.
+     */
+    std::unique_ptr<LightTree> m_lightTree;
+    std::vector<const Light *> m_infiniteLights;
+    /// @brief The probability of picking one of @ref m_infiniteLights instead of descending the light tree.
+    float m_infiniteProbability = 0;
+
+    /**
+     * @brief Remembers the primitive that last occluded a shadow ray towards each light source. Shadow rays of nearby
+     * pixels are mostly blocked by the same primitive, which can then be tested before traversing the whole scene.
+     * Every thread owns one cache, so that neither lookups nor updates need synchronization.
+     */
+    struct OccluderCache {
+        static constexpr int Size = 64;
+        struct Entry {
+            const Light *light = nullptr;
+            const Instance *instance = nullptr;
+            int primitive = -1;
+        };
+        Entry entries[Size];
+        OccluderCacheStatistics statistics;
+
+        Entry &operator[](const Light *light) { return entries[(reinterpret_cast<uintptr_t>(light) >> 4) % Size]; }
+    };
+    /// @brief Whether shadow rays test the occluder cache of their thread first.
+    bool m_occluderCache;
+    /// @brief Distinguishes scenes in the thread local lookup of caches (addresses could be re-used).
+    uint64_t m_id;
+    /// @brief The caches of all threads that have traced shadow rays in this scene.
+    mutable std::vector<std::unique_ptr<OccluderCache>> m_occluderCaches;
+    mutable std::mutex m_occluderCacheMutex;
+
+    /// @brief Returns the occluder cache of the calling thread, creating it on first use.
+    OccluderCache &occluderCache() const;
 
 public:
     Scene(const Properties &properties);
@@ -41,19 +104,33 @@ public:
     
     /// @brief Finds the closest intersection of the scene for a given ray.
     Intersection intersect(const Ray &ray, Sampler &rng) const;
-    /// @brief Reports whether any intersection up to a given maximal distance exists (used for testing visibility of light sources).
-    bool intersect(const Ray &ray, float tMax, Sampler &rng) const;
+    /**
+     * @brief Reports whether any intersection up to a given maximal distance exists (used for testing visibility of light sources).
+     * @param light The light source the ray is traced towards, if any. The primitive that last occluded a ray towards
+     * it on the same thread is tested first, and only if it does not occlude this ray is the whole scene traversed.
+     */
+    bool intersect(const Ray &ray, float tMax, Sampler &rng, const Light *light = nullptr) const;
+    /// @brief Returns how often shadow rays have been answered by the occluder cache, summed over all threads.
+    OccluderCacheStatistics occluderCacheStatistics() const;
+    /// @brief Returns the background light, or null if the scene has none.
+    BackgroundLight *background() const { return m_background.get(); }
     /// @brief Evaluates the background illumination for a given direction pointing away from the scene.
     BackgroundLightEval evaluateBackground(const Vector &direction) const;
 
+    /// @brief Returns all light sources that can be sampled.
+    const std::vector<ref<Light>> &lights() const { return m_lights; }
     /// @brief Reports whether at least one light exists that could be sampled.
     bool hasLights() const { return !m_lights.empty(); }
     /// @brief Reports whether a background light exists. 
     bool hasBackground() const { return m_background != nullptr; }
-    /// @brief Randomly picks a light from the list of sampleable light sources. 
-    LightSample sampleLight(Sampler &rng) const;
-    /// @brief Returns the probability of randomly picking a light source via @ref sampleLight .
-    float lightSelectionProbability(const Light *light) const;
+    /**
+     * @brief Randomly picks a light from the list of sampleable light sources.
+     * @param origin The point that is to be illuminated, which light trees use to prefer nearby light sources.
+     */
+    LightSample sampleLight(const Point &origin, Sampler &rng) const;
+    /// @brief Returns the probability of randomly picking a light source via @ref sampleLight (zero for light sources
+    /// that are not part of the scene).
+    float lightSelectionProbability(const Light *light, const Point &origin) const;
     /// @brief Returns the bounding box of the scene geometry.
     Bounds getBoundingBox() const;
 };
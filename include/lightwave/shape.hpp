@@ -37,6 +37,13 @@ public:
      * @note Intersections farther away than the previous value of @c its.t will be dismissed.
      */
     virtual bool intersect(const Ray &ray, Intersection &its, Sampler &rng) const = 0;
+    /**
+     * @brief Tests a single primitive of the shape (as reported by @ref Intersection::primitive ) for intersection.
+     * Shapes that do not consist of several primitives test the entire shape.
+     */
+    virtual bool intersectPrimitive(int primitive, const Ray &ray, Intersection &its, Sampler &rng) const {
+        return intersect(ray, its, rng);
+    }
     /// @brief Returns a bounding box that tightly encapsulates the shape. 
     virtual Bounds getBoundingBox() const = 0;
     /**
@@ -48,6 +55,18 @@ public:
     virtual Point getCentroid() const = 0;
     /// @brief Samples a random point on the surface of this shape.
     virtual AreaSample sampleArea(const Point &origin, Sampler &rng) const = 0;
+    /**
+     * @brief Samples a random point uniformly over the surface of this shape, independently of any point it should
+     * illuminate (e.g., to start paths at light sources). Returns an invalid sample if the shape does not support this.
+     */
+    virtual AreaSample sampleSurface(Sampler &rng) const { return AreaSample::invalid(); }
+    /**
+     * @brief Returns the surface area of the shape after applying a transform (which may be null), used to estimate the
+     * power of area lights.
+     */
+    virtual float area(const Transform *transform) const = 0;
+    /// @brief Returns a cone that contains all surface normals of the shape, used to build light trees.
+    virtual DirectionCone normalBounds() const { return DirectionCone::all(); }
 
     /**
      * @brief Marks that the shape is part of the scene geometry, i.e., can be hit through @ref Scene::intersect .
@@ -8,6 +8,7 @@
 #include "lightwave/core.hpp"
 #include "lightwave/math.hpp"
 
+#include <filesystem>
 #include <span>
 
 namespace lightwave {
@@ -21,6 +22,13 @@ public:
     ScalarImage(std::vector<float> data, Point2i resolution);
     Point2i resolution() const;
     std::span<float> data();
+
+    /// @brief Averages blocks of @c factor x @c factor values (or fewer at the right and bottom borders).
+    ScalarImage downsample(int factor) const;
+    /// @brief Writes the values to a file, e.g. to cache them across renders.
+    void save(const std::filesystem::path &path) const;
+    /// @brief Reads values written by @ref save , returning false if the file is missing or invalid.
+    bool load(const std::filesystem::path &path);
 };
 
 /// @brief Models spatially varying material properties (e.g., images or procedural noise).
@@ -40,6 +48,12 @@ public:
     virtual float scalar(const Point2 &uv) const = 0;
 
     virtual ScalarImage scalar() const = 0;
+
+    /**
+     * @brief Returns a hash of everything that determines the content of the texture, under which data derived from
+     * it can be cached across renders, or 0 if the texture does not support caching.
+     */
+    virtual uint64_t hash() const { return 0; }
 };
 
 }
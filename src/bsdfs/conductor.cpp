@@ -8,11 +8,20 @@ namespace lightwave {
 class Conductor final : public Bsdf {
     const cref<Texture> m_reflectance;
 
+    struct State {
+        Color reflectance;
+    };
+
 public:
     Conductor(const Properties &properties)
         : m_reflectance(properties.get<Texture>("reflectance")) {}
 
-    BsdfEval evaluate(const Point2 &uv, const Vector &wo,
+    void prepare(const Point2 &uv, const Vector &wo,
+                 BsdfClosure &closure) const override {
+        closure.set(State{.reflectance = m_reflectance->evaluate(uv)});
+    }
+
+    BsdfEval evaluate(const BsdfClosure &closure, const Vector &wo,
                       const Vector &wi) const override {
         // the probability of a light sample picking exactly the direction `wi'
         // that results from reflecting `wo' is zero, hence we can just ignore
@@ -20,15 +29,16 @@ public:
         return BsdfEval::invalid();
     }
 
-    BsdfSample sample(const Point2 &uv, const Vector &wo,
+    BsdfSample sample(const BsdfClosure &closure, const Vector &wo,
                       Sampler &rng) const override {
         return {.wi = reflect(wo, Vector(0, 0, 1)),
-                .weight = m_reflectance->evaluate(uv),
+                .weight = closure.get<State>().reflectance,
                 .pdf = 0};
     }
 
-    Color albedo(const Point2 &uv,
-                 const Vector &wo) const override{NOT_IMPLEMENTED}
+    Color albedo(const BsdfClosure &closure, const Vector &wo) const override {
+        return closure.get<State>().reflectance;
+    }
 
     std::string toString() const override {
         return tfm::format(
@@ -12,13 +12,34 @@ class Dielectric final : public Bsdf {
     const cref<Texture> m_reflectance;
     const cref<Texture> m_transmittance;
 
+    struct State {
+        /// @brief The relative index of refraction, as seen from @c wo .
+        float eta;
+        /// @brief The probability of reflection.
+        float fresnel;
+        Color reflectance;
+        Color transmittance;
+    };
+
 public:
     Dielectric(const Properties &properties)
         : m_ior(properties.get<Texture>("ior")),
           m_reflectance(properties.get<Texture>("reflectance")),
           m_transmittance(properties.get<Texture>("transmittance")) {}
 
-    BsdfEval evaluate(const Point2 &uv, const Vector &wo,
+    void prepare(const Point2 &uv, const Vector &wo,
+                 BsdfClosure &closure) const override {
+        const float eta = Frame::cosTheta(wo) > 0 ? m_ior->scalar(uv)
+                                                  : 1.f / m_ior->scalar(uv);
+        closure.set(State{
+            .eta = eta,
+            .fresnel = fresnelDielectric(Frame::absCosTheta(wo), eta),
+            .reflectance = m_reflectance->evaluate(uv),
+            .transmittance = m_transmittance->evaluate(uv),
+        });
+    }
+
+    BsdfEval evaluate(const BsdfClosure &closure, const Vector &wo,
                       const Vector &wi) const override {
         // the probability of a light sample picking exactly the direction `wi'
         // that results from reflecting or refracting `wo' is zero, hence we can
@@ -26,34 +47,31 @@ public:
         return BsdfEval::invalid();
     }
 
-    BsdfSample sample(const Point2 &uv, const Vector &wo,
+    BsdfSample sample(const BsdfClosure &closure, const Vector &wo,
                       Sampler &rng) const override {
+        const auto &state = closure.get<State>();
         const Vector n(0, 0, 1);
-        const float eta = Frame::cosTheta(wo) > 0 ? m_ior->scalar(uv)
-                                                  : 1.f / m_ior->scalar(uv);
         const float sgn = copysign(1, Frame::cosTheta(wo));
 
-        const auto f = fresnelDielectric(Frame::absCosTheta(wo), eta);
-        if (rng.next() <= f)
+        if (rng.next() <= state.fresnel)
             return {
                 .wi = reflect(wo, sgn * n),
-                .weight = m_reflectance->evaluate(uv),
+                .weight = state.reflectance,
                 .pdf = 0,
             };
         else
             return {
-                .wi = refract(wo, sgn * n, eta),
-                .weight = m_transmittance->evaluate(uv) / sqr(eta),
+                .wi = refract(wo, sgn * n, state.eta),
+                .weight = state.transmittance / sqr(state.eta),
                 .pdf = 0,
+                .eta = state.eta,
             };
     }
 
-    Color albedo(const Point2 &uv, const Vector &wo) const override {
-        const float eta = Frame::cosTheta(wo) > 0 ? m_ior->scalar(uv)
-                                                  : 1.f / m_ior->scalar(uv);
-        const auto f = fresnelDielectric(Frame::absCosTheta(wo), eta);
-        return f * m_reflectance->evaluate(uv) +
-               (1 - f) * m_transmittance->evaluate(uv) / sqr(eta);
+    Color albedo(const BsdfClosure &closure, const Vector &wo) const override {
+        const auto &state = closure.get<State>();
+        return state.fresnel * state.reflectance +
+               (1 - state.fresnel) * state.transmittance / sqr(state.eta);
     }
 
     std::string toString() const override {
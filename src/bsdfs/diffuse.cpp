@@ -10,36 +10,47 @@ namespace lightwave {
 class Diffuse final : public Bsdf {
     const ref<const Texture> m_albedo;
 
+    struct State {
+        Color albedo;
+    };
+
 public:
     Diffuse(const Properties &properties)
         : m_albedo(properties.get<Texture>("albedo")) {}
 
-    BsdfEval evaluate(const Point2 &uv, const Vector &wo,
+    void prepare(const Point2 &uv, const Vector &wo,
+                 BsdfClosure &closure) const override {
+        closure.set(State{.albedo = m_albedo->evaluate(uv)});
+    }
+
+    BsdfEval evaluate(const BsdfClosure &closure, const Vector &wo,
                       const Vector &wi) const override {
         if (Frame::cosTheta(wi) <= 0 || Frame::cosTheta(wo) <= 0) [[unlikely]]
             return BsdfEval::invalid();
         return {
-            .value = Frame::cosTheta(wi) * m_albedo->evaluate(uv) * InvPi,
-            .pdf = Frame::cosTheta(wi),
+            .value = Frame::cosTheta(wi) * closure.get<State>().albedo * InvPi,
+            .pdf = cosineHemispherePdf(wi),
         };
     }
 
-    BsdfSample sample(const Point2 &uv, const Vector &wo,
+    BsdfSample sample(const BsdfClosure &closure, const Vector &wo,
                       Sampler &rng) const override {
         if (Frame::cosTheta(wo) <= 0) [[unlikely]]
             return BsdfSample::invalid();
         auto wi = squareToCosineHemisphere(rng.next2D());
         return {
             .wi = wi,
-            .weight = m_albedo->evaluate(uv),
-            .pdf = Frame::cosTheta(wi),
+            .weight = closure.get<State>().albedo,
+            .pdf = cosineHemispherePdf(wi),
         };
     }
 
-    Color albedo(const Point2 &uv, const Vector &wo) const override {
-        return m_albedo->evaluate(uv);
+    Color albedo(const BsdfClosure &closure, const Vector &wo) const override {
+        return closure.get<State>().albedo;
     }
 
+    bool isDiffuse() const override { return true; }
+
     std::string toString() const override {
         return tfm::format(
             "Diffuse[\n"
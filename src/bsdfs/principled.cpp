@@ -16,7 +16,7 @@ struct DiffuseLobe {
     BsdfEval evaluate(const Vector &wo, const Vector &wi) const {
         return {
             .value = Frame::cosTheta(wi) * color * InvPi,
-            .pdf = Frame::cosTheta(wi),
+            .pdf = cosineHemispherePdf(wi),
         };
     }
 
@@ -25,7 +25,7 @@ struct DiffuseLobe {
         return {
             .wi = wi,
             .weight = color,
-            .pdf = Frame::cosTheta(wi),
+            .pdf = cosineHemispherePdf(wi),
         };
     }
 };
@@ -65,6 +65,7 @@ class Principled final : public Bsdf {
     ref<Texture> m_metallic;
     ref<Texture> m_specular;
 
+    /// @brief The lobes at a surface point, which serve as the closure of the Bsdf.
     struct Combination {
         float diffuseSelectionProb;
         DiffuseLobe diffuse;
@@ -106,12 +107,17 @@ public:
         m_specular = properties.get<Texture>("specular");
     }
 
-    BsdfEval evaluate(const Point2 &uv, const Vector &wo,
+    void prepare(const Point2 &uv, const Vector &wo,
+                 BsdfClosure &closure) const override {
+        closure.set(combine(uv, wo));
+    }
+
+    BsdfEval evaluate(const BsdfClosure &closure, const Vector &wo,
                       const Vector &wi) const override {
         if (Frame::cosTheta(wi) <= 0 || Frame::cosTheta(wo) <= 0) [[unlikely]]
             return BsdfEval::invalid();
 
-        const auto combination = combine(uv, wo);
+        const auto &combination = closure.get<Combination>();
         const auto diffuse = combination.diffuse.evaluate(wo, wi);
         const auto metallic = combination.metallic.evaluate(wo, wi);
         return {
@@ -121,11 +127,11 @@ public:
         };
     }
 
-    BsdfSample sample(const Point2 &uv, const Vector &wo,
+    BsdfSample sample(const BsdfClosure &closure, const Vector &wo,
                       Sampler &rng) const override {
         if (Frame::cosTheta(wo) <= 0) [[unlikely]]
             return BsdfSample::invalid();
-        const auto combination = combine(uv, wo);
+        const auto &combination = closure.get<Combination>();
         BsdfSample bsdf;
         if (rng.next() < combination.diffuseSelectionProb) {
             bsdf = combination.diffuse.sample(wo, rng);
@@ -140,10 +146,10 @@ public:
         return bsdf;
     }
 
-    Color albedo(const Point2 &uv, const Vector &wo) const override {
+    Color albedo(const BsdfClosure &closure, const Vector &wo) const override {
         if (Frame::cosTheta(wo) <= 0) [[unlikely]]
             return Color::black();
-        const auto combination = combine(uv, wo);
+        const auto &combination = closure.get<Combination>();
         return combination.diffuse.color + combination.metallic.color;
     }
 
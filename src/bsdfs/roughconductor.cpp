@@ -12,19 +12,33 @@ class RoughConductor final : public Bsdf {
     const cref<Texture> m_reflectance;
     const cref<Texture> m_roughness;
 
+    struct State {
+        float alpha;
+        Color reflectance;
+    };
+
 public:
     RoughConductor(const Properties &properties)
         : m_reflectance(properties.get<Texture>("reflectance")),
           m_roughness(properties.get<Texture>("roughness")) {}
 
-    BsdfEval evaluate(const Point2 &uv, const Vector &wo,
+    void prepare(const Point2 &uv, const Vector &wo,
+                 BsdfClosure &closure) const override {
+        closure.set(State{
+            .alpha = std::max(float(1e-3), sqr(m_roughness->scalar(uv))),
+            .reflectance = m_reflectance->evaluate(uv),
+        });
+    }
+
+    BsdfEval evaluate(const BsdfClosure &closure, const Vector &wo,
                       const Vector &wi) const override {
         if (Frame::cosTheta(wi) <= 0 || Frame::cosTheta(wo) <= 0) [[unlikely]]
             return BsdfEval::invalid();
 
-        const auto alpha = std::max(float(1e-3), sqr(m_roughness->scalar(uv)));
+        const auto &state = closure.get<State>();
+        const auto alpha = state.alpha;
         auto wm = (wi + wo).normalized();
-        auto R = m_reflectance->evaluate(uv);
+        auto R = state.reflectance;
         auto D = microfacet::evaluateGGX(alpha, wm);
         auto G1_wi = microfacet::smithG1(alpha, wm, wi),
              G1_wo = microfacet::smithG1(alpha, wm, wo);
@@ -35,14 +49,15 @@ public:
         };
     }
 
-    BsdfSample sample(const Point2 &uv, const Vector &wo,
+    BsdfSample sample(const BsdfClosure &closure, const Vector &wo,
                       Sampler &rng) const override {
         if (Frame::cosTheta(wo) <= 0) [[unlikely]]
             return BsdfSample::invalid();
 
-        const auto alpha = std::max(float(1e-3), sqr(m_roughness->scalar(uv)));
+        const auto &state = closure.get<State>();
+        const auto alpha = state.alpha;
         auto wm = microfacet::sampleGGXVNDF(alpha, wo, rng.next2D());
-        auto R = m_reflectance->evaluate(uv);
+        auto R = state.reflectance;
         auto wi = reflect(wo, wm);
         auto G1_wi = microfacet::smithG1(alpha, wm, wi);
         return {
@@ -53,8 +68,8 @@ public:
         };
     }
 
-    Color albedo(const Point2 &uv, const Vector &wo) const override {
-        return m_reflectance->evaluate(uv);
+    Color albedo(const BsdfClosure &closure, const Vector &wo) const override {
+        return closure.get<State>().reflectance;
     }
 
     std::string toString() const override {
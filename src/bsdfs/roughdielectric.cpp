@@ -15,6 +15,14 @@ class RoughDielectric final : public Bsdf {
     const cref<Texture> m_transmittance;
     const cref<Texture> m_roughness;
 
+    struct State {
+        /// @brief The relative index of refraction, as seen from @c wo .
+        float eta;
+        float alpha;
+        Color reflectance;
+        Color transmittance;
+    };
+
 public:
     RoughDielectric(const Properties &properties)
         : m_ior(properties.get<Texture>("ior")),
@@ -22,7 +30,18 @@ public:
           m_transmittance(properties.get<Texture>("transmittance")),
           m_roughness(properties.get<Texture>("roughness")) {}
 
-    BsdfEval evaluate(const Point2 &uv, const Vector &wo,
+    void prepare(const Point2 &uv, const Vector &wo,
+                 BsdfClosure &closure) const override {
+        closure.set(State{
+            .eta = Frame::cosTheta(wo) > 0 ? m_ior->scalar(uv)
+                                           : 1.f / m_ior->scalar(uv),
+            .alpha = std::max(float(1e-3), sqr(m_roughness->scalar(uv))),
+            .reflectance = m_reflectance->evaluate(uv),
+            .transmittance = m_transmittance->evaluate(uv),
+        });
+    }
+
+    BsdfEval evaluate(const BsdfClosure &closure, const Vector &wo,
                       const Vector &wi) const override {
         const auto cosTheta_o = Frame::cosTheta(wo),
                    cosTheta_i = Frame::cosTheta(wi);
@@ -30,56 +49,59 @@ public:
             [[unlikely]]
             return BsdfEval::invalid();
 
-        const auto eta =
-            cosTheta_o > 0 ? m_ior->scalar(uv) : 1.f / m_ior->scalar(uv);
+        const auto &state = closure.get<State>();
+        const auto eta = state.eta;
         const bool reflect = cosTheta_i * cosTheta_o > 0;
         const auto etap = reflect ? 1 : eta;
         Vector wm = wi * etap + wo;
         wm = std::copysign(1.f, Frame::cosTheta(wm)) * wm.normalized();
 
         const auto f = fresnelDielectric(wo.dot(wm), eta);
-        const auto alpha = std::max(float(1e-3), sqr(m_roughness->scalar(uv)));
+        const auto alpha = state.alpha;
         const auto G = microfacet::smithG1(alpha, wm, wi) *
                        microfacet::smithG1(alpha, wm, wo);
         auto D = microfacet::evaluateGGX(alpha, wm);
         if (reflect) {
-            const auto R = m_reflectance->evaluate(uv);
+            const auto R = state.reflectance;
             return {
                 .value = R * f * G * D * microfacet::detReflection(wm, wo),
                 .pdf = microfacet::pdfGGXVNDF(alpha, wm, wo) *
                        microfacet::detReflection(wm, wo),
             };
         } else {
-            const auto T = m_transmittance->evaluate(uv);
+            const auto T = state.transmittance;
             return {
                 .value = T * (1 - f) * G * D *
                          microfacet::detRefraction(wm, wi, wo, eta) /
                          std::abs(cosTheta_o),
                 .pdf = microfacet::pdfGGXVNDF(alpha, wm, wo) *
                        microfacet::detRefraction(wm, wi, wo, eta),
+                .eta = eta,
             };
         }
     }
 
-    BsdfSample sample(const Point2 &uv, const Vector &wo,
+    BsdfSample sample(const BsdfClosure &closure, const Vector &wo,
                       Sampler &rng) const override {
-        const auto alpha = std::max(float(1e-3), sqr(m_roughness->scalar(uv)));
+        const auto &state = closure.get<State>();
+        const auto alpha = state.alpha;
         const auto wm = microfacet::sampleGGXVNDF(alpha, wo, rng.next2D());
-        const float eta = Frame::cosTheta(wo) > 0 ? m_ior->scalar(uv)
-                                                  : 1.f / m_ior->scalar(uv);
+        const float eta = state.eta;
         const auto f = fresnelDielectric(wo.dot(wm), eta);
         Vector wi;
         Color w;
         float pdf;
+        float relativeEta = 1;
 
         if (rng.next() <= f) {
             wi = reflect(wo, wm);
-            w = m_reflectance->evaluate(uv);
+            w = state.reflectance;
             pdf = microfacet::detReflection(wm, wo);
         } else {
             wi = refract(wo, wm, eta);
-            w = m_transmittance->evaluate(uv) / sqr(eta);
+            w = state.transmittance / sqr(eta);
             pdf = microfacet::detRefraction(wm, wi, wo, eta);
+            relativeEta = eta;
         }
 
         const auto G1_wi = microfacet::smithG1(alpha, wm, wi);
@@ -87,15 +109,15 @@ public:
             .wi = wi,
             .weight = w * G1_wi * Frame::absCosTheta(wi),
             .pdf = microfacet::pdfGGXVNDF(alpha, wm, wo) * pdf,
+            .eta = relativeEta,
         };
     }
 
-    Color albedo(const Point2 &uv, const Vector &wo) const override {
-        const float eta = Frame::cosTheta(wo) > 0 ? m_ior->scalar(uv)
-                                                  : 1.f / m_ior->scalar(uv);
-        const auto f = fresnelDielectric(Frame::absCosTheta(wo), eta);
-        return f * m_reflectance->evaluate(uv) +
-               (1 - f) * m_transmittance->evaluate(uv) / sqr(eta);
+    Color albedo(const BsdfClosure &closure, const Vector &wo) const override {
+        const auto &state = closure.get<State>();
+        const auto f = fresnelDielectric(Frame::absCosTheta(wo), state.eta);
+        return f * state.reflectance +
+               (1 - f) * state.transmittance / sqr(state.eta);
     }
 
     std::string toString() const override {
@@ -23,6 +23,11 @@ public:
             z = aspect_ratio_inv / std::tan(Deg2Rad * fov / 2);
         else
             throw std::runtime_error("Invalid fovAxis: " + fovAxis);
+
+        m_origin = m_transform->apply(Point(0));
+        // the image plane at distance z is spanned by these two vectors (in world space)
+        m_imageNormal = m_transform->apply(Vector(1, 0, 0))
+                            .cross(m_transform->apply(Vector(0, aspect_ratio_inv, 0)));
     }
 
     CameraSample sample(const Point2 &normalized, Sampler &rng) const override {
@@ -33,6 +38,32 @@ public:
         return CameraSample{.ray = ray_world, .weight = Color(1.0f)};
     }
 
+    bool supportsConnections() const override { return true; }
+
+    CameraConnection connect(const Point &point, Sampler &rng) const override {
+        auto [distance, direction] = Vector(point - m_origin).lengthAndNormalized();
+        Point2 normalized;
+        const float pdf = directionPdf(direction, normalized);
+        if (pdf == 0)
+            return CameraConnection::invalid();
+
+        // the importance is chosen such that camera samples have a weight of one, i.e., it equals the density of the
+        // direction divided by the cosine at the image plane. connecting to the pinhole has a density of distance
+        // squared over that cosine in solid angle, so the cosines cancel
+        return {
+            .wi = -direction,
+            .weight = Color(pdf / sqr(distance)),
+            .distance = distance,
+            .pixel = Point2((normalized.x() + 1) / 2 * m_resolution.x(),
+                            (normalized.y() + 1) / 2 * m_resolution.y()),
+        };
+    }
+
+    float pdf(const Vector &direction) const override {
+        Point2 normalized;
+        return directionPdf(direction, normalized);
+    }
+
     std::string toString() const override {
         return tfm::format(
             "Perspective[\n"
@@ -47,6 +78,32 @@ public:
 
 private:
     float aspect_ratio_inv, z;
+    /// @brief The position of the pinhole in world space.
+    Point m_origin;
+    /// @brief The cross product of the axes of the image plane in world space, whose length is the area of a unit
+    /// step in normalized coordinates.
+    Vector m_imageNormal;
+
+    /**
+     * @brief Computes the density (in solid angle) of sampling a direction in world space, and the normalized
+     * coordinates of the image it passes through. Returns zero for directions outside the image.
+     */
+    float directionPdf(const Vector &direction, Point2 &normalized) const {
+        Vector local = m_transform->inverse(direction);
+        if (local.z() <= 0)
+            return 0;
+        local *= z / local.z();
+        normalized = Point2(local.x(), local.y() / aspect_ratio_inv);
+        if (std::abs(normalized.x()) > 1 || std::abs(normalized.y()) > 1)
+            return 0;
+
+        // normalized coordinates are uniform over an area of four, and map to the image plane at distance |M v|
+        const float distance2 = m_transform->apply(local).lengthSquared();
+        const float projected = std::abs(m_imageNormal.dot(direction));
+        if (projected == 0)
+            return 0;
+        return distance2 / (4 * projected);
+    }
 };
 
 }
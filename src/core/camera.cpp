@@ -4,8 +4,11 @@
 namespace lightwave {
 
 CameraSample Camera::sample(const Point2i &pixel, Sampler &rng) const {
-    // begin by sampling a random position within the pixel
-    const auto pixelPlusRandomOffset = Vector2(pixel.cast<float>()) + Vector2(rng.next2D());
+    // begin by sampling a random position within the pixel, or around the pixel center if a filter is given. as the
+    // filter is importance sampled, the weight of the sample is unaffected
+    const auto pixelPlusRandomOffset = m_filter
+        ? Vector2(pixel.cast<float>()) + Vector2(0.5f) + m_filter->sample(rng.next2D())
+        : Vector2(pixel.cast<float>()) + Vector2(rng.next2D());
     // normalize by image resolution to end up with value in range [-1,-1] to [+1,+1]
     const auto normalized = 2 * pixelPlusRandomOffset / m_resolution.cast<float>() - Vector2(1);
     // generate the sample using the normalized sample function
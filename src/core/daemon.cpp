@@ -0,0 +1,125 @@
+#include <lightwave/logger.hpp>
+
+#include "daemon.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#ifndef LW_OS_WINDOWS
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace lightwave {
+
+void executeScene(const std::filesystem::path &scenePath, ObjectCache *cache) {
+    SceneParser parser { scenePath, cache };
+    for (auto &object : parser.objects()) {
+        if (auto executable = dynamic_cast<Executable *>(object.get())) {
+            executable->execute();
+        }
+    }
+}
+
+/// @brief Concatenates the messages of an exception and all exceptions nested within it.
+static std::string describe(const std::exception &e) {
+    std::string message = e.what();
+    try {
+        std::rethrow_if_nested(e);
+    } catch (const std::exception &nestedException) {
+        message += "\n" + describe(nestedException);
+    } catch (...) {}
+    return message;
+}
+
+std::string RenderDaemon::run(const std::string &job) {
+    std::vector<std::string> arguments;
+    std::istringstream stream { job };
+    for (std::string argument; stream >> std::quoted(argument);)
+        arguments.push_back(argument);
+
+    std::string error;
+    try {
+        options = m_defaults;
+        const auto scenePath = parseArguments(arguments, options);
+        if (scenePath.empty()) {
+            lightwave_throw("please specify path to scene");
+        }
+        Timer timer;
+        executeScene(scenePath, &m_cache);
+        logger(EInfo, "finished %s in %.2f seconds", scenePath, timer.getElapsedTime());
+    } catch (const std::exception &e) {
+        error = describe(e);
+        logger(EError, "%s", error);
+    }
+    m_cache.nextGeneration();
+    return error;
+}
+
+void RenderDaemon::serve(std::istream &input) {
+    logger(EInfo, "waiting for jobs on stdin (\"quit\" to stop)");
+    for (std::string job; std::getline(input, job);) {
+        if (job == "quit")
+            break;
+        if (!job.empty())
+            run(job);
+    }
+}
+
+#ifndef LW_OS_WINDOWS
+void RenderDaemon::listen(const std::filesystem::path &socketPath) {
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.string().size() >= sizeof(address.sun_path)) {
+        lightwave_throw("socket path %s is too long", socketPath);
+    }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    const int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    std::filesystem::remove(socketPath);
+    if (server < 0 || bind(server, (sockaddr *) &address, sizeof(address)) < 0 || ::listen(server, 4) < 0) {
+        lightwave_throw("could not listen on %s: %s", socketPath, std::strerror(errno));
+    }
+    logger(EInfo, "waiting for jobs on %s (\"quit\" to stop)", socketPath);
+
+    bool quit = false;
+    while (!quit) {
+        const int client = accept(server, nullptr, nullptr);
+        if (client < 0)
+            continue;
+
+        // jobs are rendered one after another, as each job already uses all cores
+        std::string buffer;
+        char chunk[1024];
+        ssize_t received;
+        while (!quit && (received = recv(client, chunk, sizeof(chunk), 0)) > 0) {
+            buffer.append(chunk, received);
+            size_t end;
+            while (!quit && (end = buffer.find('\n')) != std::string::npos) {
+                const std::string job = buffer.substr(0, end);
+                buffer.erase(0, end + 1);
+                if (job == "quit") {
+                    quit = true;
+                } else if (!job.empty()) {
+                    const std::string error = run(job);
+                    const std::string reply = error.empty() ? "ok\n" : "error: " + error + "\n";
+                    send(client, reply.data(), reply.size(), MSG_NOSIGNAL);
+                }
+            }
+        }
+        close(client);
+    }
+
+    close(server);
+    std::filesystem::remove(socketPath);
+}
+#else
+void RenderDaemon::listen(const std::filesystem::path &socketPath) {
+    lightwave_throw("UNIX sockets are not supported on Windows, please pass jobs via stdin instead");
+}
+#endif
+
+}
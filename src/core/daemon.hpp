@@ -0,0 +1,39 @@
+#pragma once
+
+#include <lightwave/core.hpp>
+#include <lightwave/options.hpp>
+
+#include "parser.hpp"
+
+#include <filesystem>
+#include <istream>
+
+namespace lightwave {
+
+/// @brief Parses a scene file and executes all executables (e.g., integrators and tests) at its root.
+void executeScene(const std::filesystem::path &scenePath, ObjectCache *cache = nullptr);
+
+/**
+ * @brief Renders a sequence of jobs while keeping the objects of their scenes warm in an @ref ObjectCache , so that
+ * look-dev iterations only pay for re-creating the parts of the scene that changed.
+ * Each job is a line with the same arguments lightwave accepts on the command line (e.g., "scene.xml --samples 0 4"),
+ * and the line "quit" stops the daemon.
+ */
+class RenderDaemon {
+    ObjectCache m_cache;
+    /// @brief The options the daemon has been started with, which each job starts from.
+    Options m_defaults;
+
+public:
+    RenderDaemon(size_t cacheSize) : m_cache(cacheSize), m_defaults(options) {}
+
+    /// @brief Runs a single job, and returns an empty string on success or a description of what failed.
+    std::string run(const std::string &job);
+
+    /// @brief Runs jobs read line by line from a stream (e.g., stdin) until it ends.
+    void serve(std::istream &input);
+    /// @brief Runs jobs received from clients of a UNIX socket, and replies "ok" or "error: <message>" to each job.
+    void listen(const std::filesystem::path &socketPath);
+};
+
+}
@@ -1,16 +1,71 @@
 #include <lightwave/distribution.hpp>
+#include <lightwave/parallel.hpp>
 
 #include <algorithm>
 #include <numeric>
+#include <ranges>
 #include <span>
 #include <vector>
 
 namespace lightwave {
 
+AliasTable::AliasTable(std::span<const float> weights) {
+    const size_t size = weights.size();
+    m_bins.resize(size);
+    if (!size)
+        return;
+    const double sum = std::accumulate(weights.begin(), weights.end(), 0.0);
+
+    // entries are scaled such that a probability of 1 fills exactly one bin
+    std::vector<double> scaled(size);
+    std::vector<uint32_t> under, over;
+    for (size_t i = 0; i < size; i++) {
+        const double pdf = sum > 0 ? weights[i] / sum : 1.0 / size;
+        m_bins[i].pdf = float(pdf);
+        scaled[i] = pdf * size;
+        (scaled[i] < 1 ? under : over).push_back(uint32_t(i));
+    }
+
+    while (!under.empty() && !over.empty()) {
+        const uint32_t small = under.back(), large = over.back();
+        under.pop_back();
+        over.pop_back();
+        // the large entry fills the remainder of the bin of the small one
+        m_bins[small].threshold = float(scaled[small]);
+        m_bins[small].alias = large;
+        scaled[large] -= 1 - scaled[small];
+        (scaled[large] < 1 ? under : over).push_back(large);
+    }
+    // only round-off remains, and the leftover entries fill their bins on their own
+    for (uint32_t i : under)
+        m_bins[i] = { m_bins[i].pdf, 1, i };
+    for (uint32_t i : over)
+        m_bins[i] = { m_bins[i].pdf, 1, i };
+}
+
+Sample1D AliasTable::sample(float u) const {
+    const float scaled = u * m_bins.size();
+    const size_t bin = std::min(size_t(scaled), m_bins.size() - 1);
+    const float remainder = std::min(scaled - bin, OneMinusEpsilon);
+    const Bin &b = m_bins[bin];
+    if (remainder < b.threshold) {
+        return {
+            .index = bin,
+            .u = std::min(remainder / b.threshold, OneMinusEpsilon),
+            .pdf = b.pdf,
+        };
+    }
+    return {
+        .index = b.alias,
+        .u = std::min((remainder - b.threshold) / (1 - b.threshold), OneMinusEpsilon),
+        .pdf = m_bins[b.alias].pdf,
+    };
+}
+
 Distribution1D::Distribution1D() {}
 
-Distribution1D::Distribution1D(std::span<float> data) {
-    m_data = data;
+Distribution1D::Distribution1D(std::span<const float> data) {
+    m_data.assign(data.begin(), data.end());
     m_size = data.size();
     m_cdf.resize(m_size + 1, 0.f);
     std::transform_inclusive_scan(m_data.begin(),
@@ -25,19 +80,36 @@ Distribution1D::Distribution1D(std::span<float> data) {
     else
         std::for_each(
             m_cdf.begin(), m_cdf.end(), [&](float &v) { v /= m_sum; });
+    // normalization may round the last value below 1, which would let random numbers close to 1 run off the end
+    m_cdf.back() = 1;
+
+    // a single pass suffices to find the entries of all cells, as both are sorted
+    m_guide.resize(m_size);
+    uint32_t offset = 0;
+    for (size_t cell = 0; cell < m_size; cell++) {
+        const float u = float(cell) / float(m_size);
+        while (offset + 1 < m_size && m_cdf[offset + 1] <= u)
+            offset++;
+        m_guide[cell] = offset;
+    }
 }
 
-std::span<float> Distribution1D::data() const { return m_data; }
+std::span<const float> Distribution1D::data() const { return m_data; }
 
-Sample1D Distribution1D::sampleContinous(Sampler &rng) const {
-    float u = rng.next();
-    auto it = std::upper_bound(m_cdf.cbegin(), m_cdf.cend(), u) - 1;
-    size_t offset = std::distance(m_cdf.cbegin(), it);
+std::span<const float> Distribution1D::cdf() const { return m_cdf; }
+
+Sample1D Distribution1D::sampleContinous(float u) const {
+    const size_t cell = std::min(size_t(u * m_size), m_size - 1);
+    size_t offset = m_guide[cell];
+    // the cell computed from u may be off by one due to round-off, in which case we step back
+    while (offset > 0 && m_cdf[offset] > u)
+        offset--;
+    while (offset + 1 < m_size && m_cdf[offset + 1] <= u)
+        offset++;
     float du = u - m_cdf[offset];
     if (m_cdf[offset + 1] - m_cdf[offset] > 0)
         du /= (m_cdf[offset + 1] - m_cdf[offset]);
     float pdf = (m_sum == 0) ? 1.f : (m_data[offset] / m_sum);
-    // pdf = std::max(1.f, pdf);
     return {
         .index = offset,
         .u = (offset + du) / m_size,
@@ -52,16 +124,17 @@ Distribution2D::Distribution2D() {}
 Distribution2D::Distribution2D(ScalarImage scalar) {
     m_resolution = scalar.resolution();
     size_t width = m_resolution.x(), height = m_resolution.y();
-    m_marginal_data.reserve(height);
+    std::vector<float> marginal(height);
+    m_conditional.resize(height);
 
-    for (size_t i = 0; i < height; i++) {
+    // the rows are independent of each other, which makes them cheap to build in parallel
+    for_each_parallel(std::views::iota(size_t(0), height), [&](size_t i) {
         std::span<float> subspan = scalar.data().subspan(i * width, width);
-        Distribution1D dist(subspan);
-        m_marginal_data.emplace_back(dist.sum());
-        m_conditional.emplace_back(dist);
-    }
+        m_conditional[i] = Distribution1D(subspan);
+        marginal[i] = m_conditional[i].sum();
+    });
 
-    m_marginal = Distribution1D(m_marginal_data);
+    m_marginal = Distribution1D(marginal);
 }
 
 float Distribution2D::pdf(Point2 uv) const {
@@ -70,14 +143,20 @@ float Distribution2D::pdf(Point2 uv) const {
     size_t iv =
         std::clamp(int(uv.y() * m_resolution.y()), 0, m_resolution.y() - 1);
     return m_conditional[iv].data()[iu] / m_marginal.sum();
-    // return std::max(1.f, m_conditional[iv].data()[iu] / m_marginal.sum());
 }
 
-Sample2D Distribution2D::sampleContinous(Sampler &rng) const {
-    auto s = m_marginal.sampleContinous(rng);
-    auto c = m_conditional[s.index].sampleContinous(rng);
+Sample2D Distribution2D::sampleContinous(Point2 u) const {
+    auto s = m_marginal.sampleContinous(u.y());
+    auto c = m_conditional[s.index].sampleContinous(u.x());
     Point2 uv = {c.u, s.u};
     return {uv, s.pdf * c.pdf};
 }
 
-}
\ No newline at end of file
+Sample2D Distribution2D::sampleContinous(Sampler &rng) const {
+    // the row is drawn first, which keeps the order of random numbers of earlier versions
+    const float v = rng.next();
+    const float u = rng.next();
+    return sampleContinous(Point2(u, v));
+}
+
+}
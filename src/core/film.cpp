@@ -0,0 +1,238 @@
+#include <lightwave/film.hpp>
+#include <lightwave/logger.hpp>
+#include <lightwave/parallel.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace lightwave {
+
+/// @brief Identifies film files, and is changed whenever their layout changes.
+static constexpr char FilmMagic[8] = { 'L', 'W', 'F', 'I', 'L', 'M', '0', '2' };
+
+/// @brief The header preceding the pixel estimates in film files.
+struct FilmHeader {
+    char magic[8];
+    int32_t width;
+    int32_t height;
+    int32_t pass;
+    int32_t pixelSize;
+    /// @brief The region of the film that has been saved (in scanline order).
+    int32_t regionMin[2];
+    int32_t regionMax[2];
+};
+
+void Film::initialize(const Point2i &resolution) {
+    m_resolution = resolution;
+    m_pixels.resize(resolution.x() * resolution.y());
+    std::fill(m_pixels.begin(), m_pixels.end(), PixelEstimate());
+}
+
+void Film::copy(const Film &other, const Bounds2i &block) {
+    for (auto pixel : block)
+        (*this)(pixel) = other(pixel);
+}
+
+void Film::merge(const Film &other) {
+    assert(other.m_resolution == m_resolution);
+    for (size_t i = 0; i < m_pixels.size(); i++)
+        m_pixels[i].merge(other.m_pixels[i]);
+}
+
+void Film::save(const std::filesystem::path &path, int pass,
+                const Bounds2i &region) const {
+    FilmHeader header;
+    std::memcpy(header.magic, FilmMagic, sizeof(header.magic));
+    header.width     = m_resolution.x();
+    header.height    = m_resolution.y();
+    header.pass      = pass;
+    header.pixelSize = sizeof(PixelEstimate);
+    for (int dim = 0; dim < 2; dim++) {
+        header.regionMin[dim] = region.min()[dim];
+        header.regionMax[dim] = region.max()[dim];
+    }
+    assert(!region.isEmpty());
+
+    auto temporaryPath = path;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        // rows of the region are contiguous in memory, which keeps the files
+        // of distributed renders small
+        const int width = region.diagonal().x();
+        for (int y = region.min().y(); y < region.max().y(); y++) {
+            file.write(reinterpret_cast<const char *>(
+                           &(*this)(Point2i(region.min().x(), y))),
+                       width * sizeof(PixelEstimate));
+        }
+        if (!file) {
+            logger(EError, "could not write %s", temporaryPath);
+            return;
+        }
+    }
+    std::filesystem::rename(temporaryPath, path);
+}
+
+int Film::load(const std::filesystem::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        lightwave_throw("could not open %s", path);
+    }
+
+    FilmHeader header;
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file ||
+        std::memcmp(header.magic, FilmMagic, sizeof(header.magic)) != 0 ||
+        header.pixelSize != sizeof(PixelEstimate)) {
+        lightwave_throw("%s is not a valid film file", path);
+    }
+
+    initialize(Point2i(header.width, header.height));
+    const Bounds2i region(
+        Point2i(header.regionMin[0], header.regionMin[1]),
+        Point2i(header.regionMax[0], header.regionMax[1]));
+    if (region.isEmpty() || !bounds().includes(region.min()) ||
+        !bounds().includes(region.max())) {
+        lightwave_throw("region of %s exceeds its resolution", path);
+    }
+
+    const int width = region.diagonal().x();
+    for (int y = region.min().y(); y < region.max().y(); y++) {
+        file.read(reinterpret_cast<char *>(&(*this)(Point2i(region.min().x(), y))),
+                  width * sizeof(PixelEstimate));
+    }
+    if (!file) {
+        lightwave_throw("%s is truncated", path);
+    }
+    return header.pass;
+}
+
+int64_t Film::totalSamples() const {
+    int64_t total = 0;
+    for (const auto &pixel : m_pixels)
+        total += pixel.count;
+    return total;
+}
+
+void Film::develop(Image &image, const Bounds2i &block) const {
+    for (auto pixel : block)
+        image(pixel) = (*this)(pixel).value();
+}
+
+void Film::developSampleCount(Image &image) const {
+    image.initialize(m_resolution);
+    for (auto pixel : bounds())
+        image(pixel) = Color(float((*this)(pixel).count));
+}
+
+void Film::developVariance(Image &image) const {
+    image.initialize(m_resolution);
+    for (auto pixel : bounds()) {
+        const PixelEstimate &estimate = (*this)(pixel);
+        image(pixel) = Color(estimate.count ? estimate.variance() / estimate.count : 0.f);
+    }
+}
+
+void SplatFilm::initialize(const Point2i &resolution) {
+    m_resolution = resolution;
+    m_tileCount  = (Vector2i(resolution) + Vector2i(TileSize - 1)) / TileSize;
+    m_sums.assign(3 * size_t(m_tileCount.product()) * TileSize * TileSize, 0);
+}
+
+int64_t SplatFilm::toFixedPoint(float value) {
+    // a single non-finite contribution would poison the entire pixel
+    if (!std::isfinite(value))
+        return 0;
+    constexpr double Limit = 9e18;
+    return std::llround(
+        std::clamp(double(value) * FixedPointScale, -Limit, Limit));
+}
+
+Color SplatFilm::operator()(const Point2i &pixel) const {
+    const int64_t *sums = &m_sums[offset(pixel)];
+    return Color(float(sums[0] / FixedPointScale),
+                 float(sums[1] / FixedPointScale),
+                 float(sums[2] / FixedPointScale));
+}
+
+void SplatFilm::develop(Image &image, float scale) const {
+    image.initialize(m_resolution);
+    for (auto pixel : Bounds2i(Point2i(0), m_resolution))
+        image(pixel) = scale * (*this)(pixel);
+}
+
+int64_t *SplatFilm::Writer::sums(const Point2i &pixel) {
+    const int index = (pixel.y() / TileSize) * m_film.m_tileCount.x() +
+                      pixel.x() / TileSize;
+    const int local = (pixel.y() % TileSize) * TileSize + pixel.x() % TileSize;
+    for (auto &tile : m_tiles) {
+        if (tile.index == index)
+            return &tile.sums[3 * local];
+    }
+
+    Tile &tile = m_tiles[m_nextEviction];
+    m_nextEviction = (m_nextEviction + 1) % TileCacheSize;
+    flush(tile);
+    tile.index = index;
+    return &tile.sums[3 * local];
+}
+
+void SplatFilm::Writer::flush(Tile &tile) {
+    if (tile.index < 0)
+        return;
+    int64_t *target =
+        &m_film.m_sums[3 * size_t(tile.index) * TileSize * TileSize];
+    for (size_t i = 0; i < tile.sums.size(); i++) {
+        if (tile.sums[i]) {
+            atomicAdd(target[i], tile.sums[i]);
+        }
+    }
+    tile.index = -1;
+    tile.sums.fill(0);
+}
+
+void SplatFilm::Writer::flush() {
+    for (auto &tile : m_tiles)
+        flush(tile);
+}
+
+void SplatFilm::Writer::splat(const Point2 &position, const Color &value,
+                              const Filter *filter) {
+    const Bounds2i bounds(Point2i(0), m_film.m_resolution);
+    if (!filter) {
+        const Point2i pixel(int(std::floor(position.x())),
+                            int(std::floor(position.y())));
+        if (pixel.x() < 0 || pixel.y() < 0 ||
+            pixel.x() >= m_film.m_resolution.x() ||
+            pixel.y() >= m_film.m_resolution.y())
+            return;
+        int64_t *target = sums(pixel);
+        for (int channel = 0; channel < 3; channel++)
+            target[channel] += toFixedPoint(value[channel]);
+        return;
+    }
+
+    // visit all pixels whose center lies within the radius of the filter
+    const Vector2 radius(filter->radius());
+    const Bounds2i footprint = bounds.clip(Bounds2i(
+        Point2i(int(std::ceil(position.x() - 0.5f - radius.x())),
+                int(std::ceil(position.y() - 0.5f - radius.y()))),
+        Point2i(int(std::floor(position.x() - 0.5f + radius.x())) + 1,
+                int(std::floor(position.y() - 0.5f + radius.y())) + 1)));
+    if (footprint.isEmpty())
+        return;
+    for (auto pixel : footprint) {
+        const Vector2 offset = Vector2(position) -
+                               Vector2(pixel.cast<float>()) - Vector2(0.5f);
+        const float weight = filter->evaluate(offset);
+        if (weight == 0)
+            continue;
+        int64_t *target = sums(pixel);
+        for (int channel = 0; channel < 3; channel++)
+            target[channel] += toFixedPoint(weight * value[channel]);
+    }
+}
+
+} // namespace lightwave
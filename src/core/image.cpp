@@ -1,7 +1,12 @@
 #include <lightwave/core.hpp>
 #include <lightwave/image.hpp>
+#include <lightwave/parallel.hpp>
 #include <lightwave/registry.hpp>
 
+#include <bit>
+#include <cstring>
+#include <ranges>
+
 #include <stb_image.h>
 #include <tinyexr.h>
 
@@ -74,6 +79,27 @@ void Image::saveAt(const std::filesystem::path &path) const {
         logger(EError, "  error saving image %s: %s", path, error);
     }
 }
+
+uint64_t Image::hash() const {
+    // rows are hashed in parallel, as images used for importance sampling can be large
+    std::vector<uint64_t> rowHashes(m_resolution.y());
+    for_each_parallel(std::views::iota(0, m_resolution.y()), [&](int y) {
+        const auto *bytes = reinterpret_cast<const uint8_t *>(&m_data[size_t(y) * m_resolution.x()]);
+        const size_t size = m_resolution.x() * sizeof(Color);
+        uint64_t hash = 0;
+        for (size_t offset = 0; offset < size; offset += sizeof(uint64_t)) {
+            uint64_t word = 0;
+            std::memcpy(&word, bytes + offset, std::min(sizeof(uint64_t), size - offset));
+            hash = (std::rotl(hash, 29) ^ word) * 0x9e3779b97f4a7c15ull;
+        }
+        rowHashes[y] = hashMix(hash, uint64_t(y));
+    });
+
+    uint64_t hash = hashMix(uint64_t(m_resolution.x()), uint64_t(m_resolution.y()));
+    for (uint64_t rowHash : rowHashes)
+        hash = hashMix(hash, rowHash);
+    return hash;
+}
 } // namespace lightwave
 
 REGISTER_CLASS(Image, "image", "default")
@@ -20,12 +20,18 @@ void Instance::transformFrame(SurfaceEvent &surf) const {
     surf.frame = Frame(t.cross(b).normalized());
 }
 
-bool Instance::intersect(const Ray &worldRay, Intersection &its,
-                         Sampler &rng) const {
+bool Instance::intersectShape(int primitive, const Ray &worldRay,
+                              Intersection &its, Sampler &rng) const {
+    const auto intersectLocal = [&](const Ray &localRay) {
+        return primitive < 0
+                   ? m_shape->intersect(localRay, its, rng)
+                   : m_shape->intersectPrimitive(primitive, localRay, its, rng);
+    };
+
     if (!m_transform) {
         // fast path, if no transform is needed
         Ray localRay = worldRay;
-        if (m_shape->intersect(localRay, its, rng)) {
+        if (intersectLocal(localRay)) {
             its.instance = this;
             return true;
         } else {
@@ -40,7 +46,7 @@ bool Instance::intersect(const Ray &worldRay, Intersection &its,
 
     its.t *= scale;
 
-    const bool wasIntersected = m_shape->intersect(localRay, its, rng);
+    const bool wasIntersected = intersectLocal(localRay);
     if (wasIntersected) {
         its.t /= scale;
         its.instance = this;
@@ -52,6 +58,16 @@ bool Instance::intersect(const Ray &worldRay, Intersection &its,
     }
 }
 
+bool Instance::intersect(const Ray &worldRay, Intersection &its,
+                         Sampler &rng) const {
+    return intersectShape(-1, worldRay, its, rng);
+}
+
+bool Instance::intersectPrimitive(int primitive, const Ray &worldRay,
+                                  Intersection &its, Sampler &rng) const {
+    return intersectShape(primitive, worldRay, its, rng);
+}
+
 Bounds Instance::getBoundingBox() const {
     if (!m_transform) {
         // fast path
@@ -86,6 +102,26 @@ Point Instance::getCentroid() const {
     return m_transform->apply(m_shape->getCentroid());
 }
 
+DirectionCone Instance::normalBounds() const {
+    const DirectionCone cone = m_shape->normalBounds();
+    if (m_normal || (m_transform && cone.cosTheta > -1 && cone.cosTheta < 1)) {
+        // normal maps and transformed cones of non-zero width are not tracked
+        return DirectionCone::all();
+    }
+    if (!m_transform || cone.cosTheta <= -1)
+        return cone;
+
+    // transform the normal the same way intersections do (see transformFrame)
+    const Frame frame(cone.axis);
+    const Vector t = m_transform->apply(frame.tangent);
+    Vector b = m_transform->apply(frame.bitangent);
+    b = m_flipNormal ? -b : b;
+    Vector normal = t.cross(b).normalized();
+    if (frame.tangent.cross(frame.bitangent).dot(cone.axis) < 0)
+        normal = -normal;
+    return { normal, 1 };
+}
+
 AreaSample Instance::sampleArea(const Point &reference, Sampler &rng) const {
     const Point ref_local = m_transform->inverse(reference);
     AreaSample sample = m_shape->sampleArea(ref_local, rng);
@@ -94,6 +130,14 @@ AreaSample Instance::sampleArea(const Point &reference, Sampler &rng) const {
     transformFrame(sample);
     return sample;
 }
+
+AreaSample Instance::sampleSurface(Sampler &rng) const {
+    AreaSample sample = m_shape->sampleSurface(rng);
+    if (sample.isInvalid() || !m_transform)
+        return sample;
+    transformFrame(sample);
+    return sample;
+}
 }
 
 REGISTER_CLASS(Instance, "instance", "default")
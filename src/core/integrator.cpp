@@ -1,45 +1,243 @@
 #include <lightwave/integrator.hpp>
 #include <lightwave/camera.hpp>
+#include <lightwave/instance.hpp>
 #include <lightwave/parallel.hpp>
 
 #include <algorithm>
 #include <chrono>
+#include <csignal>
 
 #include <lightwave/streaming.hpp>
 #include <lightwave/iterators.hpp>
 
 namespace lightwave {
 
+bool SamplingIntegrator::hasConverged(const Bounds2i &tile) const {
+    for (auto pixel : tile) {
+        const PixelEstimate &estimate = m_film(pixel);
+        if (estimate.relativeError() >= m_adaptiveThreshold)
+            return false;
+    }
+    return true;
+}
+
+void SamplingIntegrator::recordAuxiliaryOutputs(const Point2i &pixel, const Ray &ray, Sampler &rng) {
+    if (!hasAuxiliaryOutputs())
+        return;
+    const Intersection its = m_scene->intersect(ray, rng);
+    if (m_albedo) {
+        if (!its)
+            (*m_albedo)(pixel) += m_scene->evaluateBackground(ray.direction).value;
+        else if (its.instance->emission())
+            (*m_albedo)(pixel) += its.evaluateEmission();
+        else
+            (*m_albedo)(pixel) += its.evaluateAlbedo();
+    }
+    if (its) {
+        if (m_normals)
+            (*m_normals)(pixel) += Color(its.frame.normal);
+        if (m_distance)
+            (*m_distance)(pixel) += Color(its.t);
+        if (m_position)
+            (*m_position)(pixel) += Color(Vector(its.position));
+    }
+    m_auxiliaryCount[pixel.y() * m_film.resolution().x() + pixel.x()]++;
+}
+
+int SamplingIntegrator::renderBlock(const Bounds2i &block, Sampler &sampler, int target, bool skipConverged) {
+    const int sampleOffset = options.sampleOffset;
+    int taken = 0;
+    for (auto tileIndex : Bounds2i(Vector2i(0), (block.diagonal() + Vector2i(AdaptiveTileSize - 1)) / AdaptiveTileSize)) {
+        const Point2i tileMin = block.min() + AdaptiveTileSize * Vector2i(tileIndex);
+        const Bounds2i tile = block.clip(Bounds2i(tileMin, tileMin + Vector2i(AdaptiveTileSize)));
+        if (skipConverged && hasConverged(tile))
+            continue;
+
+        for (auto pixel : tile) {
+            PixelEstimate &estimate = m_film(pixel);
+            for (int sample = estimate.count; sample < target; sample++) {
+                sampler.seed(pixel, sampleOffset + sample);
+                auto cameraSample = m_scene->camera()->sample(pixel, sampler);
+                estimate.add(cameraSample.weight * Li(cameraSample.ray, sampler));
+                recordAuxiliaryOutputs(pixel, cameraSample.ray, sampler);
+                taken++;
+            }
+        }
+    }
+    m_film.develop(*m_image, block);
+    return taken;
+}
+
+/// @brief Set when the user asks a checkpointed render to stop (e.g., via Ctrl+C).
+static volatile std::sig_atomic_t s_interrupted = 0;
+
+static void handleInterrupt(int) { s_interrupted = 1; }
+
 void SamplingIntegrator::execute() {
     if (!m_image) {
         lightwave_throw("<integrator /> needs an <image /> child to render into!");
     }
 
     const Vector2i resolution = m_scene->camera()->resolution();
+    const int spp = options.sampleCount > 0 ? options.sampleCount : m_sampler->samplesPerPixel();
     m_image->initialize(resolution);
+    m_film.initialize(resolution);
+    for (const auto &output : { m_albedo, m_normals, m_distance, m_position }) {
+        if (output)
+            output->initialize(resolution);
+    }
+    m_auxiliaryCount.assign(resolution.product(), 0);
 
-    const float norm = 1.0f / m_sampler->samplesPerPixel();
-    
-    Streaming stream { *m_image };
-    ProgressReporter progress { resolution.product() };
-    for_each_parallel(BlockSpiral(resolution, Vector2i(64)), [&](auto block) {
-        auto sampler = m_sampler->clone();
-        for (auto pixel : block) {
-            Color sum;
-            for (int sample = 0; sample < m_sampler->samplesPerPixel(); sample++) {
-                sampler->seed(pixel, sample);
-                auto cameraSample = m_scene->camera()->sample(pixel, *sampler);
-                sum += cameraSample.weight * Li(cameraSample.ray, *sampler);
+    // distributed renders restrict each process to a slice of the pixels and/or samples
+    const Bounds2i region = m_film.bounds().clip(options.region.value_or(m_film.bounds()));
+    if (region.isEmpty()) {
+        lightwave_throw("the region to render does not overlap the image");
+    }
+    if (options.sampleOffset < 0 || options.sampleCount < 0) {
+        lightwave_throw("the range of samples to render must not be negative");
+    }
+
+    // each pass brings the pixels up to an absolute number of samples. without adaptive sampling, all samples are
+    // taken before the adaptive passes would start
+    struct Pass {
+        int target;
+        bool adaptive;
+    };
+    std::vector<Pass> passes;
+    const int baseCount = m_adaptive ? std::min(m_adaptiveMinCount, spp) : spp;
+    for (int target = 0; target < baseCount;) {
+        target = std::min(target + m_passSize, baseCount);
+        passes.push_back({ target, false });
+    }
+    for (int target = baseCount; m_adaptive && target < spp;) {
+        target = std::min(target + m_adaptiveBatch, spp);
+        passes.push_back({ target, true });
+    }
+
+    size_t firstPass = 0;
+    if (options.resume) {
+        if (std::filesystem::exists(checkpointPath())) {
+            firstPass = m_film.load(checkpointPath());
+            if (m_film.resolution() != resolution) {
+                lightwave_throw("resolution of checkpoint %s does not match the camera", checkpointPath());
             }
-            m_image->get(pixel) = norm * sum;
+            m_film.develop(*m_image);
+            logger(EInfo, "resuming from checkpoint %s at pass %d", checkpointPath(), firstPass);
+        } else {
+            logger(EWarn, "no checkpoint found at %s, starting from scratch", checkpointPath());
         }
+    }
 
-        progress += block.diagonal().product();
-        stream.updateBlock(block);
-    });
+    // the snapshot only receives blocks that have finished a pass, so that it is consistent at all times
+    const bool checkpointing = m_checkpointInterval > 0;
+    Film snapshot = m_film;
+    std::mutex snapshotMutex;
+    Timer checkpointTimer;
+
+    s_interrupted = 0;
+    void (*previousSigint)(int) = nullptr;
+    void (*previousSigterm)(int) = nullptr;
+    if (checkpointing) {
+        previousSigint = std::signal(SIGINT, handleInterrupt);
+        previousSigterm = std::signal(SIGTERM, handleInterrupt);
+    }
+
+    Streaming stream { *m_image };
+    ProgressReporter progress { region.diagonal().product() * int(passes.size() - std::min(firstPass, passes.size())) };
+    Timer renderTimer;
+    const OccluderCacheStatistics previousOccluders = m_scene->occluderCacheStatistics();
+    int64_t totalTaken = 0;
+    size_t pass = firstPass;
+    for (; pass < passes.size(); pass++) {
+        std::atomic<int> taken = 0;
+        // every worker re-uses its sampler for all of its blocks, as samplers are fully reset when seeded
+        const auto cloneSampler = [&] { return m_sampler->clone(); };
+        for_each_parallel(BlockSpiral(resolution, Vector2i(64)), cloneSampler, [&](auto block, ref<Sampler> &sampler) {
+            block = region.clip(block);
+            if (s_interrupted || block.isEmpty())
+                return;
+
+            taken += renderBlock(block, *sampler, passes[pass].target, passes[pass].adaptive);
+            progress += block.diagonal().product();
+            stream.updateBlock(block);
+
+            if (checkpointing) {
+                std::unique_lock lock { snapshotMutex };
+                snapshot.copy(m_film, block);
+                if (checkpointTimer.getElapsedTime() >= m_checkpointInterval) {
+                    snapshot.save(checkpointPath(), int(pass), region);
+                    checkpointTimer = Timer();
+                }
+            }
+        });
+
+        totalTaken += taken;
+        if (s_interrupted)
+            break;
+        // blocks of a resumed pass may have been rendered before, so only stop once a full pass found no work
+        if (passes[pass].adaptive && taken == 0 && pass > firstPass)
+            break;
+    }
     progress.finish();
+    const float renderTime = renderTimer.getElapsedTime();
+    logger(EInfo, "took %ld samples in %.2fs (%.3f M samples/s)", totalTaken, renderTime,
+           1e-6f * totalTaken / std::max(renderTime, 1e-6f));
+    const OccluderCacheStatistics occluders = m_scene->occluderCacheStatistics() - previousOccluders;
+    if (occluders.rays > 0) {
+        logger(EInfo, "occluder cache answered %.1f%% of %ld shadow rays (%.1f%% of occluded ones)",
+               100.f * occluders.hits / occluders.rays, occluders.rays,
+               100.f * occluders.hits / std::max(occluders.occluded, uint64_t(1)));
+    }
+
+    if (checkpointing) {
+        std::signal(SIGINT, previousSigint);
+        std::signal(SIGTERM, previousSigterm);
+    }
 
+    if (s_interrupted) {
+        m_film.save(checkpointPath(), int(pass), region);
+        lightwave_throw("render interrupted, progress has been saved to %s (continue with --resume)", checkpointPath());
+    }
+
+    if ((checkpointing || options.resume) && std::filesystem::exists(checkpointPath())) {
+        std::filesystem::remove(checkpointPath());
+    }
+
+    if (m_adaptive) {
+        const int64_t uniformSamples = int64_t(region.diagonal().product()) * spp;
+        const int64_t totalSamples = m_film.totalSamples();
+        logger(EInfo, "adaptive sampling took %ld samples (%.1f%% of %ld)", totalSamples,
+               100.f * totalSamples / uniformSamples, uniformSamples);
+    }
+
+    if (!options.partial.empty()) {
+        if (hasAuxiliaryOutputs())
+            logger(EWarn, "auxiliary outputs are not written by partial renders");
+        m_film.save(partialPath(), int(passes.size()), region);
+        logger(EInfo, "saved partial render to %s", partialPath());
+        return;
+    }
+
+    finishImage();
     m_image->save();
+    if (m_sampleCount) {
+        m_film.developSampleCount(*m_sampleCount);
+        m_sampleCount->save();
+    }
+    if (m_variance) {
+        m_film.developVariance(*m_variance);
+        m_variance->save();
+    }
+    for (const auto &output : { m_albedo, m_normals, m_distance, m_position }) {
+        if (!output)
+            continue;
+        for (auto pixel : m_film.bounds()) {
+            const int count = m_auxiliaryCount[pixel.y() * resolution.x() + pixel.x()];
+            if (count)
+                (*output)(pixel) /= float(count);
+        }
+        output->save();
+    }
 }
 
 }
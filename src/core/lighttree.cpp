@@ -0,0 +1,284 @@
+#include <lightwave/lighttree.hpp>
+#include <lightwave/logger.hpp>
+
+#include <algorithm>
+
+namespace lightwave {
+
+/// @brief The number of buckets per axis that candidate splits are evaluated for.
+static constexpr int Buckets = 12;
+
+/// @brief Returns the smallest cone that contains two given cones.
+static DirectionCone merge(const DirectionCone &a, const DirectionCone &b) {
+    const float thetaA = safe_acos(a.cosTheta);
+    const float thetaB = safe_acos(b.cosTheta);
+    const float thetaD = safe_acos(a.axis.dot(b.axis));
+    if (std::min(thetaD + thetaB, Pi) <= thetaA)
+        return a;
+    if (std::min(thetaD + thetaA, Pi) <= thetaB)
+        return b;
+
+    const float thetaO = (thetaA + thetaD + thetaB) / 2;
+    if (thetaO >= Pi)
+        return DirectionCone::all();
+    // rotate the axis of the first cone towards the axis of the second one
+    const Vector rotationAxis = a.axis.cross(b.axis);
+    if (rotationAxis.lengthSquared() == 0)
+        return DirectionCone::all();
+    const float thetaR = thetaO - thetaA;
+    const Vector axis = a.axis * std::cos(thetaR) + rotationAxis.normalized().cross(a.axis) * std::sin(thetaR);
+    return { axis.normalized(), std::cos(thetaO) };
+}
+
+static LightBounds merge(const LightBounds &a, const LightBounds &b) {
+    Bounds bounds = a.bounds;
+    bounds.extend(b.bounds);
+    return {
+        .bounds = bounds,
+        .normals = merge(a.normals, b.normals),
+        .cosThetaE = std::min(a.cosThetaE, b.cosThetaE),
+        .twoSided = a.twoSided || b.twoSided,
+    };
+}
+
+/// @brief Computes cos(max(0, a - b)) from the sines and cosines of two angles.
+static float cosSubClamped(float sinA, float cosA, float sinB, float cosB) {
+    if (cosA > cosB)
+        return 1;
+    return cosA * cosB + sinA * sinB;
+}
+
+/// @brief Computes sin(max(0, a - b)) from the sines and cosines of two angles.
+static float sinSubClamped(float sinA, float cosA, float sinB, float cosB) {
+    if (cosA > cosB)
+        return 0;
+    return sinA * cosB - cosA * sinB;
+}
+
+static float surfaceArea(const Bounds &bounds) {
+    const auto size = bounds.diagonal();
+    return 2 * (size.x() * size.y() + size.x() * size.z() + size.y() * size.z());
+}
+
+/**
+ * @brief The cost of a cluster of light sources (the surface area orientation heuristic): its power, times the area of
+ * its bounds, times the solid angle its emission directions cover (weighted by the cosine of the emission).
+ */
+static float clusterCost(const LightBounds &bounds, float power, float aspectRatio) {
+    const float cosThetaO = bounds.normals.cosTheta;
+    const float thetaO = safe_acos(cosThetaO);
+    const float thetaW = std::min(thetaO + safe_acos(bounds.cosThetaE), Pi);
+    const float sinThetaO = safe_sqrt(1 - sqr(cosThetaO));
+    const float orientation =
+        2 * Pi * (1 - cosThetaO) +
+        Pi / 2 * (2 * thetaW * sinThetaO - std::cos(thetaO - 2 * thetaW) - 2 * thetaO * sinThetaO + cosThetaO);
+    return power * orientation * aspectRatio * surfaceArea(bounds.bounds);
+}
+
+LightTree::LightTree(const std::vector<ref<Light>> &lights, const Bounds &sceneBounds) {
+    Timer buildTimer;
+
+    std::vector<Primitive> primitives;
+    for (const auto &light : lights) {
+        const auto bounds = light->bounds();
+        if (!bounds)
+            continue;
+        // light sources that emit nothing can never be picked
+        const float power = light->power(sceneBounds).luminance();
+        if (!(power > 0) || !std::isfinite(power))
+            continue;
+        primitives.push_back({ light.get(), *bounds, power });
+    }
+    if (primitives.empty())
+        return;
+
+    m_nodes.reserve(2 * primitives.size() - 1);
+    m_nodes.emplace_back().parent = -1;
+    build(0, primitives, 0, primitives.size());
+
+    logger(EInfo,
+           "built light tree with %ld nodes for %ld lights in %.1f ms",
+           m_nodes.size(),
+           m_lights.size(),
+           buildTimer.getElapsedTime() * 1000);
+}
+
+void LightTree::build(NodeIndex index, std::vector<Primitive> &primitives, size_t begin, size_t end) {
+    Node node;
+    node.parent = m_nodes[index].parent;
+    node.bounds = primitives[begin].bounds;
+    node.power  = primitives[begin].power;
+    for (size_t i = begin + 1; i < end; i++) {
+        node.bounds = merge(node.bounds, primitives[i].bounds);
+        node.power += primitives[i].power;
+    }
+
+    if (end - begin == 1) {
+        node.leaf      = true;
+        node.leftFirst = NodeIndex(m_lights.size());
+        m_leaves[primitives[begin].light] = index;
+        m_lights.push_back(primitives[begin].light);
+        m_nodes[index] = node;
+        return;
+    }
+
+    Bounds centroids = Bounds::empty();
+    for (size_t i = begin; i < end; i++)
+        centroids.extend(primitives[i].bounds.bounds.center());
+    const auto bucketOf = [&](const Primitive &primitive, int axis) {
+        const float extent = centroids.diagonal()[axis];
+        const float offset = (primitive.bounds.bounds.center()[axis] - centroids.min()[axis]) / extent;
+        return std::clamp(int(offset * Buckets), 0, Buckets - 1);
+    };
+
+    // evaluate splits between buckets along all axes, as in the binned construction of acceleration structures
+    float bestCost = Infinity;
+    int bestAxis = -1, bestSplit = 0;
+    const Vector diagonal = node.bounds.bounds.diagonal();
+    for (int axis = 0; axis < 3; axis++) {
+        if (!(centroids.diagonal()[axis] > 0))
+            continue;
+
+        struct Bucket {
+            LightBounds bounds;
+            float power = 0;
+            int count = 0;
+        } buckets[Buckets];
+        for (size_t i = begin; i < end; i++) {
+            Bucket &bucket = buckets[bucketOf(primitives[i], axis)];
+            bucket.bounds = bucket.count ? merge(bucket.bounds, primitives[i].bounds) : primitives[i].bounds;
+            bucket.power += primitives[i].power;
+            bucket.count++;
+        }
+
+        // elongated nodes are penalized for being split across their short axes
+        const float aspectRatio = diagonal[axis] > 0 ? diagonal.maxComponent() / diagonal[axis] : 1;
+        for (int split = 1; split < Buckets; split++) {
+            Bucket left, right;
+            for (int i = 0; i < Buckets; i++) {
+                const Bucket &bucket = buckets[i];
+                if (!bucket.count)
+                    continue;
+                Bucket &side = i < split ? left : right;
+                side.bounds = side.count ? merge(side.bounds, bucket.bounds) : bucket.bounds;
+                side.power += bucket.power;
+                side.count += bucket.count;
+            }
+            if (!left.count || !right.count)
+                continue;
+
+            const float cost = clusterCost(left.bounds, left.power, aspectRatio) +
+                               clusterCost(right.bounds, right.power, aspectRatio);
+            if (cost < bestCost || bestAxis < 0) {
+                bestCost  = cost;
+                bestAxis  = axis;
+                bestSplit = split;
+            }
+        }
+    }
+
+    size_t middle = (begin + end) / 2;
+    if (bestAxis >= 0) {
+        middle = std::partition(primitives.begin() + begin,
+                                primitives.begin() + end,
+                                [&](const Primitive &primitive) {
+                                    return bucketOf(primitive, bestAxis) < bestSplit;
+                                }) -
+                 primitives.begin();
+    }
+
+    // the two children will always be contiguous in our m_nodes list
+    const NodeIndex leftChildIndex = NodeIndex(m_nodes.size());
+    node.leaf      = false;
+    node.leftFirst = leftChildIndex;
+    m_nodes[index] = node;
+    m_nodes.emplace_back().parent = index;
+    m_nodes.emplace_back().parent = index;
+
+    build(leftChildIndex, primitives, begin, middle);
+    build(leftChildIndex + 1, primitives, middle, end);
+}
+
+float LightTree::importance(const Node &node, const Point &origin) const {
+    const LightBounds &bounds = node.bounds;
+    const Point center = bounds.bounds.center();
+    const Vector toOrigin = origin - center;
+    // the distance is clamped so that query points within the bounds do not receive unbounded importance
+    const float distance2 = std::max(toOrigin.lengthSquared(), bounds.bounds.diagonal().length() / 2);
+
+    // the angle between the normals and the direction towards the query point
+    float cosThetaW = toOrigin.lengthSquared() > 0 ? bounds.normals.axis.dot(toOrigin.normalized()) : 1;
+    if (bounds.twoSided)
+        cosThetaW = std::abs(cosThetaW);
+    const float sinThetaW = safe_sqrt(1 - sqr(cosThetaW));
+
+    // the angle the bounds subtend when seen from the query point
+    float cosThetaB = -1;
+    if (!bounds.bounds.includes(origin)) {
+        const float sin2ThetaB = sqr(bounds.bounds.diagonal().length() / 2) / toOrigin.lengthSquared();
+        cosThetaB = sin2ThetaB < 1 ? safe_sqrt(1 - sin2ThetaB) : -1;
+    }
+    const float sinThetaB = safe_sqrt(1 - sqr(cosThetaB));
+
+    // the smallest angle between any normal and any direction towards the query point
+    const float cosThetaO = bounds.normals.cosTheta;
+    const float sinThetaO = safe_sqrt(1 - sqr(cosThetaO));
+    const float cosThetaX = cosSubClamped(sinThetaW, cosThetaW, sinThetaO, cosThetaO);
+    const float sinThetaX = sinSubClamped(sinThetaW, cosThetaW, sinThetaO, cosThetaO);
+    const float cosThetaP = cosSubClamped(sinThetaX, cosThetaX, sinThetaB, cosThetaB);
+    if (cosThetaP <= bounds.cosThetaE)
+        return 0;
+    return node.power * cosThetaP / distance2;
+}
+
+const Light *LightTree::sample(const Point &origin, float u, float &pdf) const {
+    pdf = 0;
+    if (m_nodes.empty() || importance(m_nodes.front(), origin) == 0)
+        return nullptr;
+
+    float probability = 1;
+    const Node *node  = &m_nodes.front();
+    while (!node->leaf) {
+        const Node &left  = m_nodes[node->leftFirst];
+        const Node &right = m_nodes[node->leftFirst + 1];
+        const float importanceLeft  = importance(left, origin);
+        const float importanceRight = importance(right, origin);
+        if (importanceLeft == 0 && importanceRight == 0)
+            return nullptr;
+
+        // descend and remap the random number to the unit interval for the next decision
+        const float probabilityLeft = importanceLeft / (importanceLeft + importanceRight);
+        if (u < probabilityLeft) {
+            u = std::min(u / probabilityLeft, OneMinusEpsilon);
+            probability *= probabilityLeft;
+            node = &left;
+        } else {
+            u = std::min((u - probabilityLeft) / (1 - probabilityLeft), OneMinusEpsilon);
+            probability *= 1 - probabilityLeft;
+            node = &right;
+        }
+    }
+    pdf = probability;
+    return m_lights[node->leftFirst];
+}
+
+float LightTree::pdf(const Light *light, const Point &origin) const {
+    const auto it = m_leaves.find(light);
+    if (it == m_leaves.end() || importance(m_nodes.front(), origin) == 0)
+        return 0;
+
+    // multiply the probabilities of all decisions on the path from the root to the leaf
+    float probability = 1;
+    for (NodeIndex index = it->second; m_nodes[index].parent >= 0; index = m_nodes[index].parent) {
+        const Node &parent = m_nodes[m_nodes[index].parent];
+        const float importanceLeft  = importance(m_nodes[parent.leftFirst], origin);
+        const float importanceRight = importance(m_nodes[parent.leftFirst + 1], origin);
+        const float importanceSelf  = index == parent.leftFirst ? importanceLeft : importanceRight;
+        if (importanceSelf == 0)
+            return 0;
+        probability *= importanceSelf / (importanceLeft + importanceRight);
+    }
+    return probability;
+}
+
+}
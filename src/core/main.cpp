@@ -1,10 +1,13 @@
 #include <lightwave/core.hpp>
 #include <lightwave/registry.hpp>
 #include <lightwave/logger.hpp>
+#include <lightwave/options.hpp>
+#include <lightwave/properties.hpp>
 
-#include "parser.hpp"
+#include "daemon.hpp"
 
 #include <fstream>
+#include <iostream>
 
 #ifdef LW_OS_WINDOWS
 #include <cstdlib>
@@ -21,6 +24,12 @@ void print_exception(const std::exception &e, int level = 0) {
     } catch(...) {}
 }
 
+void printUsage(const char *executable) {
+    logger(EInfo, "usage: %s <scene.xml> [--checkpoint <seconds>] [--resume] [--region <x0,y0> <x1,y1>] "
+                  "[--samples <first> <count>] [--partial <name>]", executable);
+    logger(EInfo, "   or: %s --daemon [--socket <path>] [--cache <objects>] [--checkpoint <seconds>]", executable);
+}
+
 int main(int argc, const char *argv[]) {
 #ifdef LW_DEBUG
     logger(EWarn, "lightwave was compiled in Debug mode, expect rendering to be much slower");
@@ -35,19 +44,54 @@ int main(int argc, const char *argv[]) {
 #endif
 
     try {
-        if (argc <= 1) {
-            logger(EError, "please specify path to scene");
+        // options of the daemon itself, all other arguments describe the render job
+        bool daemon = false;
+        std::filesystem::path socketPath;
+        size_t cacheSize = 4096;
+        std::vector<std::string> arguments;
+        for (int i = 1; i < argc; i++) {
+            const std::string arg = argv[i];
+            if (arg == "--daemon") {
+                daemon = true;
+            } else if (arg == "--socket" && i + 1 < argc) {
+                socketPath = argv[++i];
+            } else if (arg == "--cache" && i + 1 < argc) {
+                cacheSize = size_t(std::max(parse_string<int>(argv[++i]), 0));
+            } else {
+                arguments.push_back(arg);
+            }
+        }
+
+        std::filesystem::path scenePath;
+        try {
+            scenePath = parseArguments(arguments, options);
+        } catch (const std::exception &e) {
+            print_exception(e);
+            printUsage(argv[0]);
             return -1;
         }
-        
-        std::filesystem::path scenePath = argv[1];
 
-        SceneParser parser { scenePath };
-        for (auto &object : parser.objects()) {
-            if (auto executable = dynamic_cast<Executable *>(object.get())) {
-                executable->execute();
+        if (daemon) {
+            // remaining options act as defaults for all jobs
+            if (!scenePath.empty()) {
+                logger(EError, "the daemon receives scenes as jobs, not on the command line");
+                return -1;
             }
+            RenderDaemon renderDaemon { cacheSize };
+            if (socketPath.empty()) {
+                renderDaemon.serve(std::cin);
+            } else {
+                renderDaemon.listen(socketPath);
+            }
+            return 0;
+        }
+
+        if (scenePath.empty()) {
+            logger(EError, "please specify path to scene");
+            printUsage(argv[0]);
+            return -1;
         }
+        executeScene(scenePath);
     } catch(const std::exception &e) {
         print_exception(e);
         return 1;
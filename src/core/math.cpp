@@ -145,10 +145,18 @@ Color Intersection::evaluateEmission() const {
     return instance->emission()->evaluate(uv, frame.toLocal(wo)).value;
 }
 
+const BsdfClosure &Intersection::bsdfClosure() const {
+    if (!m_hasBsdfClosure) {
+        instance->bsdf()->prepare(uv, frame.toLocal(wo), m_bsdfClosure);
+        m_hasBsdfClosure = true;
+    }
+    return m_bsdfClosure;
+}
+
 BsdfSample Intersection::sampleBsdf(Sampler &rng) const {
     if (!instance->bsdf()) return BsdfSample::invalid();
     assert_normalized(wo, { logger(EError, "instance: %s", instance); });
-    auto bsdfSample = instance->bsdf()->sample(uv, frame.toLocal(wo), rng);
+    auto bsdfSample = instance->bsdf()->sample(bsdfClosure(), frame.toLocal(wo), rng);
     if (bsdfSample.isInvalid()) return bsdfSample;
     assert_normalized(bsdfSample.wi, {
         logger(EError, "offending BSDF: %s", instance->bsdf()->toString());
@@ -164,10 +172,10 @@ BsdfSample Intersection::sampleBsdf(Sampler &rng) const {
 BsdfEval Intersection::evaluateBsdf(const Vector &wi) const {
     if (!instance->bsdf()) [[unlikely]]
         return BsdfEval::invalid();
-    return instance->bsdf()->evaluate(uv, frame.toLocal(wo), frame.toLocal(wi));
+    return instance->bsdf()->evaluate(bsdfClosure(), frame.toLocal(wo), frame.toLocal(wi));
 }
 
 Color Intersection::evaluateAlbedo() const {
-    return instance->bsdf()->albedo(uv, frame.toLocal(wo));
+    return instance->bsdf()->albedo(bsdfClosure(), frame.toLocal(wo));
 }
 }
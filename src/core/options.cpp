@@ -0,0 +1,35 @@
+#include <lightwave/options.hpp>
+#include <lightwave/properties.hpp>
+
+namespace lightwave {
+
+Options options;
+
+std::filesystem::path parseArguments(const std::vector<std::string> &arguments, Options &options) {
+    std::filesystem::path scenePath;
+    for (size_t i = 0; i < arguments.size(); i++) {
+        const std::string &arg = arguments[i];
+        const size_t remaining = arguments.size() - i - 1;
+        if (arg == "--resume") {
+            options.resume = true;
+        } else if (arg == "--checkpoint" && remaining >= 1) {
+            options.checkpointInterval = parse_string<float>(arguments[++i]);
+        } else if (arg == "--region" && remaining >= 2) {
+            const auto min = parse_string<Point2i>(arguments[++i]);
+            const auto max = parse_string<Point2i>(arguments[++i]);
+            options.region = Bounds2i(min, max);
+        } else if (arg == "--samples" && remaining >= 2) {
+            options.sampleOffset = parse_string<int>(arguments[++i]);
+            options.sampleCount = parse_string<int>(arguments[++i]);
+        } else if (arg == "--partial" && remaining >= 1) {
+            options.partial = arguments[++i];
+        } else if (arg.starts_with("--") || !scenePath.empty()) {
+            lightwave_throw("unexpected argument \"%s\"", arg);
+        } else {
+            scenePath = arg;
+        }
+    }
+    return scenePath;
+}
+
+}
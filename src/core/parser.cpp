@@ -2,6 +2,7 @@
 #include <lightwave/registry.hpp>
 #include <lightwave/transform.hpp>
 
+#include <algorithm>
 #include <istream>
 #include <iostream>
 #include <fstream>
@@ -60,6 +61,36 @@ struct SceneParser::RootNode : public SceneParser::Node {
     }
 };
 
+ref<Object> ObjectCache::lookup(const std::string &key) {
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        m_misses++;
+        return nullptr;
+    }
+    m_hits++;
+    it->second.lastUse = m_generation;
+    return it->second.object;
+}
+
+void ObjectCache::insert(const std::string &key, const ref<Object> &object) {
+    m_entries[key] = { object, m_generation };
+}
+
+void ObjectCache::nextGeneration() {
+    logger(EInfo, "re-used %d of %d cacheable objects", m_hits, m_hits + m_misses);
+    if (m_entries.size() > m_capacity) {
+        std::vector<std::pair<uint64_t, std::string>> entries;
+        for (const auto &[key, entry] : m_entries)
+            entries.emplace_back(entry.lastUse, key);
+        std::sort(entries.begin(), entries.end());
+        for (size_t i = 0; i < m_entries.size() - m_capacity; i++)
+            m_entries.erase(entries[i].second);
+    }
+    m_generation++;
+    m_hits = 0;
+    m_misses = 0;
+}
+
 struct SceneParser::ObjectNode : public SceneParser::Node {
     std::string tag;
     std::string type;
@@ -67,6 +98,11 @@ struct SceneParser::ObjectNode : public SceneParser::Node {
     std::string id;
     Properties properties;
 
+    /// @brief Describes the attributes and children of the node, which identifies its object in the @ref ObjectCache .
+    std::string signature;
+    /// @brief Whether all children of the node can be re-used in later parses.
+    bool cacheable = true;
+
     ref<Transform> transform;
 
     ObjectNode(const std::string &tag, const ref<Node> &parent)
@@ -81,9 +117,28 @@ struct SceneParser::ObjectNode : public SceneParser::Node {
             id = value;
         } else {
             properties.set<std::string>(key, value);
+            signature += key + "=" + value + ";";
+            if (key == "filename") {
+                // changes to referenced files must invalidate cached objects
+                const auto path = properties.basePath() / value;
+                std::error_code error;
+                signature += tfm::format("@%s:%d:%d;", std::filesystem::absolute(path, error),
+                    std::filesystem::last_write_time(path, error).time_since_epoch().count(),
+                    std::filesystem::file_size(path, error));
+            }
         }
     }
 
+    /// @brief Whether objects of this node may be re-used in later parses. Instances are excluded as they are linked
+    /// to their lights, and so are objects that hold render output (and the objects they are part of).
+    bool isCacheable() const {
+        if (tag == "instance" || tag == "scene" || tag == "integrator" || tag == "test" || tag == "postprocess")
+            return false;
+        if (tag == "image" && !properties.has("filename"))
+            return false;
+        return cacheable;
+    }
+
     void enter() override {
         if (tag == "transform") {
             transform = std::static_pointer_cast<Transform>(Registry::create(tag, type, properties));
@@ -91,6 +146,15 @@ struct SceneParser::ObjectNode : public SceneParser::Node {
     }
 
     void addChild(const ref<Object> &object, const std::string &child_name) override {
+        auto &infos = getRoot().sceneParser.m_objectInfos;
+        auto info = infos.find(object.get());
+        if (info != infos.end()) {
+            signature += "<" + child_name + ">" + info->second.hash + ";";
+            cacheable &= info->second.cacheable;
+        } else {
+            cacheable = false;
+        }
+
         if (child_name == "") {
             const bool needsQuery = id == "";
             properties.addChild(object, needsQuery);
@@ -100,12 +164,27 @@ struct SceneParser::ObjectNode : public SceneParser::Node {
     }
 
     void close() override {
-        ref<Object> object = transform ? transform : Registry::create(tag, type, properties);
+        auto &sceneParser = getRoot().sceneParser;
+        const std::string key = tag + "|" + type + "|" + id + "|" + signature;
+        const bool useCache = sceneParser.m_cache && isCacheable();
+
+        ref<Object> object = useCache ? sceneParser.m_cache->lookup(key) : nullptr;
+        if (object) {
+            properties.markAsQueried();
+        } else {
+            object = transform ? transform : Registry::create(tag, type, properties);
+            if (id != "") {
+                object->setId(id);
+            }
+            if (useCache) {
+                sceneParser.m_cache->insert(key, object);
+            }
+        }
+
         if (id != "") {
-            object->setId(id);
             getRoot().nameObject(id, object);
         }
-
+        sceneParser.m_objectInfos[object.get()] = { tfm::format("%016x", std::hash<std::string>()(key)), isCacheable() };
         parent->addChild(object, name);
     }
 };
@@ -137,6 +216,7 @@ struct SceneParser::PrimitiveNode : public SceneParser::Node {
             lightwave_throw("parameters can only be specified on objects");
         }
 
+        parent_node->signature += tag + ":" + name + "=" + value + ";";
         if (tag == "float") {
             parent_node->properties.set(name, parse_string<float>(value));
         } else if (tag == "string") {
@@ -203,6 +283,7 @@ struct SceneParser::ReferenceNode : public SceneParser::Node {
 struct SceneParser::TransformNode : public SceneParser::Node {
     std::string tag;
     Transform *transform;
+    ObjectNode *owner;
 
     // for matrix
     Matrix4x4 matrix;
@@ -217,14 +298,16 @@ struct SceneParser::TransformNode : public SceneParser::Node {
     Vector axis;
     float angle;
 
-    TransformNode(const std::string &tag, const ref<Node> &parent) : Node(parent), tag(tag) {
-        if (auto p = dynamic_cast<ObjectNode *>(parent.get())) {
-            transform = p->transform.get();
+    TransformNode(const std::string &tag, const ref<Node> &parent) : Node(parent), tag(tag), transform(nullptr) {
+        owner = dynamic_cast<ObjectNode *>(parent.get());
+        if (owner) {
+            transform = owner->transform.get();
         }
 
         if (!transform) {
             lightwave_throw("<%s /> can only be applied on <transform />", tag);
         }
+        owner->signature += "<" + tag + ">";
 
         if (tag == "translate") value = Vector(0); else
         if (tag == "scale") value = Vector(1);
@@ -235,6 +318,7 @@ struct SceneParser::TransformNode : public SceneParser::Node {
     }
 
     void attribute(const std::string &attr_key, const std::string &attr_value) override {
+        owner->signature += attr_key + "=" + attr_value + ";";
         if (tag == "matrix") {
             if (attr_key == "value") { this->matrix = parse_string<Matrix4x4>(attr_value); return; }
         }
@@ -324,7 +408,7 @@ void SceneParser::close() {
     m_stack.pop();
 }
 
-SceneParser::SceneParser(const std::filesystem::path &path) {
+SceneParser::SceneParser(const std::filesystem::path &path, ObjectCache *cache) : m_cache(cache) {
     m_stack.push(std::make_shared<RootNode>(m_objects, path, *this));
     XMLParser(*this, path);
 }
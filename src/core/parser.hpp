@@ -7,10 +7,42 @@
 #include <vector>
 #include <stack>
 #include <map>
+#include <unordered_map>
 #include <filesystem>
 
 namespace lightwave {
 
+/**
+ * @brief Keeps the objects of scene files alive across several parses (e.g., in daemon mode), so that objects whose
+ * XML subtree and referenced files have not changed are re-used instead of being re-created. This avoids reloading
+ * meshes and textures and rebuilding their acceleration structures.
+ * Entries are keyed by a description of the subtree that created them and evicted in least recently used order.
+ */
+class ObjectCache {
+    struct Entry {
+        ref<Object> object;
+        /// @brief The generation (i.e., job) that the entry has last been used in.
+        uint64_t lastUse;
+    };
+
+    std::unordered_map<std::string, Entry> m_entries;
+    size_t m_capacity;
+    uint64_t m_generation = 0;
+    int m_hits = 0;
+    int m_misses = 0;
+
+public:
+    ObjectCache(size_t capacity) : m_capacity(capacity) {}
+
+    /// @brief Returns the object created for a given key, or nullptr if there is none.
+    ref<Object> lookup(const std::string &key);
+    /// @brief Stores the object that has been created for a given key.
+    void insert(const std::string &key, const ref<Object> &object);
+    /// @brief Reports the hit rate of the current generation, evicts the least recently used entries that exceed the
+    /// capacity, and starts a new generation.
+    void nextGeneration();
+};
+
 class SceneParser : public XMLParser::Delegate {
 protected:
     struct Node;
@@ -21,8 +53,18 @@ protected:
     struct ReferenceNode;
     struct TransformNode;
 
+    /// @brief What the parser knows about each object it has created (or taken from the cache).
+    struct ObjectInfo {
+        /// @brief A hash of the XML subtree (and referenced files) the object has been created from.
+        std::string hash;
+        /// @brief Whether the object can be re-used in later parses (see @ref ObjectCache ).
+        bool cacheable;
+    };
+
     std::stack<ref<Node>> m_stack;
     std::vector<ref<Object>> m_objects;
+    ObjectCache *m_cache;
+    std::unordered_map<const Object *, ObjectInfo> m_objectInfos;
 
     std::string resolveVariables(const std::string &value);
 
@@ -32,7 +74,7 @@ protected:
     void close() override;
 
 public:
-    SceneParser(const std::filesystem::path &path);
+    SceneParser(const std::filesystem::path &path, ObjectCache *cache = nullptr);
     std::vector<ref<Object>> objects() const;
 };
 
@@ -4,6 +4,9 @@
 #include <lightwave/shape.hpp>
 #include <lightwave/camera.hpp>
 #include <lightwave/light.hpp>
+#include <lightwave/instance.hpp>
+
+#include <atomic>
 
 namespace lightwave {
 
@@ -20,6 +23,43 @@ Scene::Scene(const Properties &properties) {
     }
 
     m_shape->markAsVisible();
+
+    static std::atomic<uint64_t> s_nextId = 1;
+    m_id = s_nextId++;
+    m_occluderCache = properties.get<bool>("occluderCache", true);
+
+    const std::string selection = properties.get<std::string>("lightSelection", "power");
+    if (selection != "power" && selection != "uniform" && selection != "tree") {
+        lightwave_throw("unknown light selection strategy \"%s\"", selection);
+    }
+    if (selection == "tree") {
+        m_lightTree = std::make_unique<LightTree>(m_lights, getBoundingBox());
+        for (const auto &light : m_lights) {
+            if (!light->bounds())
+                m_infiniteLights.push_back(light.get());
+        }
+        if (!m_infiniteLights.empty()) {
+            m_infiniteProbability =
+                float(m_infiniteLights.size()) / (m_infiniteLights.size() + (m_lightTree->empty() ? 0 : 1));
+        }
+    } else {
+        std::vector<float> weights(m_lights.size(), 1.f);
+        if (selection == "power") {
+            const Bounds bounds = getBoundingBox();
+            for (size_t i = 0; i < m_lights.size(); i++) {
+                const float power = m_lights[i]->power(bounds).luminance();
+                if (!std::isfinite(power) || power < 0) {
+                    logger(EWarn, "could not estimate the power of all lights, falling back to uniform light selection");
+                    std::fill(weights.begin(), weights.end(), 1.f);
+                    break;
+                }
+                weights[i] = power;
+            }
+        }
+        m_lightSelection = AliasTable(weights);
+    }
+    for (size_t i = 0; i < m_lights.size(); i++)
+        m_lightIndices[m_lights[i].get()] = i;
 }
 
 std::string Scene::toString() const {
@@ -27,9 +67,11 @@ std::string Scene::toString() const {
         "Scene[\n"
         "  camera = %s,\n"
         "  shape = %s,\n"
+        "  occluderCache = %s,\n"
         "]",
         indent(m_camera),
-        indent(m_shape)
+        indent(m_shape),
+        m_occluderCache
     );
 }
 
@@ -39,9 +81,49 @@ Intersection Scene::intersect(const Ray &ray, Sampler &rng) const {
     return its;
 }
 
-bool Scene::intersect(const Ray &ray, float tMax, Sampler &rng) const {
+bool Scene::intersect(const Ray &ray, float tMax, Sampler &rng, const Light *light) const {
     Intersection its(-ray.direction, tMax * (1 - Epsilon));
-    return m_shape->intersect(ray, its, rng);
+    if (!light || !m_occluderCache)
+        return m_shape->intersect(ray, its, rng);
+
+    OccluderCache &cache = occluderCache();
+    OccluderCache::Entry &entry = cache[light];
+    cache.statistics.rays++;
+    if (entry.light == light && entry.instance->intersectPrimitive(entry.primitive, ray, its, rng)) {
+        cache.statistics.occluded++;
+        cache.statistics.hits++;
+        return true;
+    }
+    if (!m_shape->intersect(ray, its, rng))
+        return false;
+    cache.statistics.occluded++;
+    if (its.instance)
+        entry = { light, its.instance, its.primitive };
+    return true;
+}
+
+Scene::OccluderCache &Scene::occluderCache() const {
+    thread_local struct {
+        uint64_t scene = 0;
+        OccluderCache *cache = nullptr;
+    } current;
+    if (current.scene != m_id) {
+        std::unique_lock lock { m_occluderCacheMutex };
+        current.cache = m_occluderCaches.emplace_back(std::make_unique<OccluderCache>()).get();
+        current.scene = m_id;
+    }
+    return *current.cache;
+}
+
+OccluderCacheStatistics Scene::occluderCacheStatistics() const {
+    std::unique_lock lock { m_occluderCacheMutex };
+    OccluderCacheStatistics result;
+    for (const auto &cache : m_occluderCaches) {
+        result.rays += cache->statistics.rays;
+        result.occluded += cache->statistics.occluded;
+        result.hits += cache->statistics.hits;
+    }
+    return result;
 }
 
 BackgroundLightEval Scene::evaluateBackground(const Vector &direction) const {
@@ -50,17 +132,44 @@ BackgroundLightEval Scene::evaluateBackground(const Vector &direction) const {
     return m_background->evaluate(direction);
 }
 
-LightSample Scene::sampleLight(Sampler &rng) const {
-    int lightIndex = int(rng.next() * m_lights.size());
-    lightIndex = std::min(lightIndex, int(m_lights.size()) - 1);
+LightSample Scene::sampleLight(const Point &origin, Sampler &rng) const {
+    float u = rng.next();
+    if (!m_lightTree) {
+        const Sample1D sample = m_lightSelection.sample(u);
+        return {
+            .light = m_lights[sample.index].get(),
+            .probability = sample.pdf,
+        };
+    }
+
+    if (u < m_infiniteProbability) {
+        const size_t index = std::min(size_t(u / m_infiniteProbability * m_infiniteLights.size()),
+                                      m_infiniteLights.size() - 1);
+        return {
+            .light = m_infiniteLights[index],
+            .probability = m_infiniteProbability / m_infiniteLights.size(),
+        };
+    }
+    u = std::min((u - m_infiniteProbability) / (1 - m_infiniteProbability), OneMinusEpsilon);
+    float pdf;
+    const Light *light = m_lightTree->sample(origin, u, pdf);
     return {
-        .light = m_lights[lightIndex].get(),
-        .probability = float(1) / m_lights.size(),
+        .light = light,
+        .probability = (1 - m_infiniteProbability) * pdf,
     };
 }
 
-float Scene::lightSelectionProbability(const Light *light) const {
-    return float(1) / m_lights.size();
+float Scene::lightSelectionProbability(const Light *light, const Point &origin) const {
+    if (!m_lightTree) {
+        const auto it = m_lightIndices.find(light);
+        return it == m_lightIndices.end() ? 0 : m_lightSelection.pdf(it->second);
+    }
+
+    if (m_lightTree->contains(light))
+        return (1 - m_infiniteProbability) * m_lightTree->pdf(light, origin);
+    if (std::find(m_infiniteLights.begin(), m_infiniteLights.end(), light) != m_infiniteLights.end())
+        return m_infiniteProbability / m_infiniteLights.size();
+    return 0;
 }
 
 Bounds Scene::getBoundingBox() const {
@@ -1,13 +1,94 @@
 #include "lightwave/texture.hpp"
+#include "lightwave/logger.hpp"
 
+#include <cstring>
+#include <fstream>
+#include <random>
 #include <span>
 
 namespace lightwave {
+
+/// @brief Identifies scalar image files, and is changed whenever their layout changes.
+static constexpr char ScalarImageMagic[8] = { 'L', 'W', 'S', 'C', 'A', 'L', '0', '1' };
+
+/// @brief The header preceding the values in scalar image files.
+struct ScalarImageHeader {
+    char magic[8];
+    int32_t width;
+    int32_t height;
+};
+
 ScalarImage::ScalarImage() {}
 ScalarImage::ScalarImage(std::vector<float> data, Point2i resolution)
-    : m_data(data), m_resolution(resolution) {}
+    : m_data(std::move(data)), m_resolution(resolution) {}
 
 Point2i ScalarImage::resolution() const { return m_resolution; }
 
 std::span<float> ScalarImage::data() { return std::span(m_data); }
-}
\ No newline at end of file
+
+ScalarImage ScalarImage::downsample(int factor) const {
+    const Point2i resolution((m_resolution.x() + factor - 1) / factor, (m_resolution.y() + factor - 1) / factor);
+    std::vector<float> data(size_t(resolution.x()) * resolution.y());
+    for (int y = 0; y < resolution.y(); y++) {
+        for (int x = 0; x < resolution.x(); x++) {
+            float sum = 0;
+            int count = 0;
+            for (int sy = y * factor; sy < std::min((y + 1) * factor, m_resolution.y()); sy++) {
+                for (int sx = x * factor; sx < std::min((x + 1) * factor, m_resolution.x()); sx++) {
+                    sum += m_data[size_t(sy) * m_resolution.x() + sx];
+                    count++;
+                }
+            }
+            data[size_t(y) * resolution.x() + x] = sum / count;
+        }
+    }
+    return ScalarImage(std::move(data), resolution);
+}
+
+void ScalarImage::save(const std::filesystem::path &path) const {
+    ScalarImageHeader header;
+    std::memcpy(header.magic, ScalarImageMagic, sizeof(header.magic));
+    header.width  = m_resolution.x();
+    header.height = m_resolution.y();
+
+    // concurrent renders may write the same file, so it only appears once it is complete
+    auto temporaryPath = path;
+    temporaryPath += tfm::format(".%08x.tmp", std::random_device()());
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(m_data.data()), m_data.size() * sizeof(float));
+        if (!file) {
+            logger(EWarn, "could not write %s", temporaryPath);
+            std::error_code error;
+            std::filesystem::remove(temporaryPath, error);
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error)
+        logger(EWarn, "could not write %s: %s", path, error.message());
+}
+
+bool ScalarImage::load(const std::filesystem::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    ScalarImageHeader header;
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, ScalarImageMagic, sizeof(header.magic)) != 0 || header.width <= 0 ||
+        header.height <= 0)
+        return false;
+
+    std::vector<float> data(size_t(header.width) * header.height);
+    file.read(reinterpret_cast<char *>(data.data()), data.size() * sizeof(float));
+    if (!file)
+        return false;
+
+    m_data       = std::move(data);
+    m_resolution = Point2i(header.width, header.height);
+    return true;
+}
+}
@@ -18,6 +18,17 @@ public:
         return EmissionEval{.value = m_emission->evaluate(uv)};
     }
 
+    Color exitance() const override {
+        // integrating the constant radiance over the hemisphere yields a factor of pi, and the texture is averaged
+        // over a grid since it only serves as an estimate
+        constexpr int Resolution = 16;
+        Color sum;
+        for (int y = 0; y < Resolution; y++)
+            for (int x = 0; x < Resolution; x++)
+                sum += m_emission->evaluate(Point2((x + 0.5f) / Resolution, (y + 0.5f) / Resolution));
+        return Pi * sum / float(sqr(Resolution));
+    }
+
     std::string toString() const override {
         return tfm::format(
             "Lambertian[\n"
@@ -0,0 +1,37 @@
+#include <lightwave.hpp>
+
+namespace lightwave {
+
+/// @brief A box filter, which weights all samples within its radius equally.
+class BoxFilter final : public Filter {
+    float m_radius;
+
+public:
+    BoxFilter(const Properties &properties) {
+        m_radius = properties.get<float>("radius", 0.5f);
+    }
+
+    float radius() const override { return m_radius; }
+
+    float evaluate(const Vector2 &offset) const override {
+        if (abs(offset.x()) > m_radius || abs(offset.y()) > m_radius)
+            return 0;
+        return 1 / sqr(2 * m_radius);
+    }
+
+    Vector2 sample(const Point2 &rnd) const override {
+        return m_radius * (2 * Vector2(rnd) - Vector2(1));
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "BoxFilter[\n"
+            "  radius = %s\n"
+            "]",
+            m_radius);
+    }
+};
+
+} // namespace lightwave
+
+REGISTER_FILTER(BoxFilter, "box")
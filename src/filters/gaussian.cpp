@@ -0,0 +1,97 @@
+#include <lightwave.hpp>
+
+namespace lightwave {
+
+/// @brief A Gaussian filter, truncated at its radius.
+class GaussianFilter final : public Filter {
+    float m_stddev;
+    float m_radius;
+    /// @brief The cumulative distribution of the untruncated Gaussian at the
+    /// radius.
+    float m_cdfRadius;
+
+    /// @brief The cumulative distribution function of the untruncated
+    /// Gaussian.
+    float cdf(float x) const {
+        return 0.5f * (1 + std::erf(x / (m_stddev * Sqrt2)));
+    }
+
+    /**
+     * @brief Inverse of the error function, using the single precision
+     * approximation by Giles ("Approximating the erfinv function", 2010).
+     */
+    static float erfinv(float x) {
+        float w = -std::log(max((1 - x) * (1 + x), 1e-30f));
+        float p;
+        if (w < 5) {
+            w = w - 2.5f;
+            p = 2.81022636e-08f;
+            p = 3.43273939e-07f + p * w;
+            p = -3.5233877e-06f + p * w;
+            p = -4.39150654e-06f + p * w;
+            p = 0.00021858087f + p * w;
+            p = -0.00125372503f + p * w;
+            p = -0.00417768164f + p * w;
+            p = 0.246640727f + p * w;
+            p = 1.50140941f + p * w;
+        } else {
+            w = sqrt(w) - 3;
+            p = -0.000200214257f;
+            p = 0.000100950558f + p * w;
+            p = 0.00134934322f + p * w;
+            p = -0.00367342844f + p * w;
+            p = 0.00573950773f + p * w;
+            p = -0.0076224613f + p * w;
+            p = 0.00943887047f + p * w;
+            p = 1.00167406f + p * w;
+            p = 2.83297682f + p * w;
+        }
+        return p * x;
+    }
+
+    /// @brief Maps a uniform number in [0,1] to the truncated Gaussian by
+    /// inverting its cumulative distribution.
+    float sampleAxis(float u) const {
+        const float truncated = std::lerp(1 - m_cdfRadius, m_cdfRadius, u);
+        return clamp(m_stddev * Sqrt2 * erfinv(2 * truncated - 1), -m_radius,
+                     m_radius);
+    }
+
+    float evaluateAxis(float x) const {
+        if (abs(x) > m_radius)
+            return 0;
+        const float normalization =
+            (2 * m_cdfRadius - 1) * m_stddev * sqrt(2 * Pi);
+        return std::exp(-sqr(x) / (2 * sqr(m_stddev))) / normalization;
+    }
+
+public:
+    GaussianFilter(const Properties &properties) {
+        m_stddev    = properties.get<float>("stddev", 0.5f);
+        m_radius    = properties.get<float>("radius", 3 * m_stddev);
+        m_cdfRadius = cdf(m_radius);
+    }
+
+    float radius() const override { return m_radius; }
+
+    float evaluate(const Vector2 &offset) const override {
+        return evaluateAxis(offset.x()) * evaluateAxis(offset.y());
+    }
+
+    Vector2 sample(const Point2 &rnd) const override {
+        return Vector2(sampleAxis(rnd.x()), sampleAxis(rnd.y()));
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "GaussianFilter[\n"
+            "  stddev = %s,\n"
+            "  radius = %s\n"
+            "]",
+            m_stddev, m_radius);
+    }
+};
+
+} // namespace lightwave
+
+REGISTER_FILTER(GaussianFilter, "gaussian")
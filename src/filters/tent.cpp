@@ -0,0 +1,44 @@
+#include <lightwave.hpp>
+
+namespace lightwave {
+
+/// @brief A tent (i.e., bilinear) filter, whose weight falls off linearly
+/// towards its radius.
+class TentFilter final : public Filter {
+    float m_radius;
+
+    /// @brief Maps a uniform number in [0,1] to [-1,+1] distributed according
+    /// to the unit tent function.
+    static float sampleTent(float u) {
+        return u < 0.5f ? sqrt(2 * u) - 1 : 1 - sqrt(2 - 2 * u);
+    }
+
+public:
+    TentFilter(const Properties &properties) {
+        m_radius = properties.get<float>("radius", 1.f);
+    }
+
+    float radius() const override { return m_radius; }
+
+    float evaluate(const Vector2 &offset) const override {
+        const float x = max(m_radius - abs(offset.x()), 0);
+        const float y = max(m_radius - abs(offset.y()), 0);
+        return x * y / sqr(sqr(m_radius));
+    }
+
+    Vector2 sample(const Point2 &rnd) const override {
+        return m_radius * Vector2(sampleTent(rnd.x()), sampleTent(rnd.y()));
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "TentFilter[\n"
+            "  radius = %s\n"
+            "]",
+            m_radius);
+    }
+};
+
+} // namespace lightwave
+
+REGISTER_FILTER(TentFilter, "tent")
@@ -0,0 +1,523 @@
+#include "lightwave/camera.hpp"
+#include "lightwave/instance.hpp"
+#include "lightwave/integrator.hpp"
+#include "lightwave/light.hpp"
+#include "lightwave/registry.hpp"
+
+#include <unordered_map>
+
+namespace lightwave {
+
+/**
+ * @brief A bidirectional path tracer (Veach, "Robust Monte Carlo Methods for Light Transport Simulation", 1997).
+ *
+ * For every camera sample, one path is traced from the camera and another one from a light source that has been
+ * picked proportionally to its power. Connecting each vertex of the camera path to each vertex of the light path
+ * yields one estimate per sampling strategy, for paths of every length up to the maximal depth. The strategies are
+ * combined by multiple importance sampling with the power heuristic, whose weights are computed from ratios of the
+ * densities of neighboring vertices in a single sweep over the path (as in pbrt). Connections of light path vertices
+ * to the camera (i.e., light tracing) land on arbitrary pixels, and are splatted into a @ref SplatFilm that is added
+ * to the image once all samples have been taken.
+ *
+ * Light paths start at light sources that support @ref Light::sampleEmission (area and point lights). Light sources
+ * that are infinitely far away (environment maps, directional lights) are left to the camera paths, which combine
+ * next event estimation and BSDF sampling for them as in the "mispathtracer" integrator.
+ */
+class BidirectionalPathTracerIntegrator final : public SamplingIntegrator {
+    /// @brief A vertex of a camera or light path.
+    struct Vertex {
+        enum class Type : uint8_t { Camera, Light, Surface };
+
+        Type type;
+        /// @brief Whether the direction leaving the vertex was sampled from a delta distribution (e.g., by glass).
+        bool delta;
+        /// @brief The surface at the vertex (of which only the position is meaningful for cameras and point lights).
+        /// For surfaces, @c wo points towards the previous vertex of the path.
+        Intersection its;
+        /// @brief The light source of the first vertex of light paths.
+        const Light *light;
+        /// @brief The contribution of the path up to this vertex, divided by the densities it was sampled with.
+        Color beta;
+        /// @brief The density of sampling the vertex from the previous vertex of its path, in area.
+        float pdfFwd;
+        /// @brief The density of sampling the vertex from the next vertex of its path (i.e., in reverse), in area.
+        float pdfRev;
+
+        const Point &position() const { return its.position; }
+        /// @brief Whether densities of reaching the vertex include the cosine at a surface.
+        bool isOnSurface() const {
+            return type == Type::Surface || (type == Type::Light && light->canBeIntersected());
+        }
+        bool isDeltaLight() const { return type == Type::Light && !light->canBeIntersected(); }
+        /// @brief Whether a camera path has hit an emissive surface at this vertex.
+        bool isEmissive() const { return type == Type::Surface && its.instance->emission(); }
+    };
+
+    /// @brief The ray by which a camera path has left the scene.
+    struct Escape {
+        /// @brief The index of the vertex the ray started at, or -1 if the path did not leave the scene.
+        int from;
+        Vector direction;
+        /// @brief The contribution of the path including the ray, divided by the densities it was sampled with.
+        Color beta;
+        /// @brief The density of the direction in solid angle (zero for delta distributions).
+        float pdf;
+    };
+
+    /// @brief The buffers of a worker, which are allocated once per block so that tracing paths never allocates.
+    struct Context {
+        std::vector<Vertex> cameraPath;
+        std::vector<Vertex> lightPath;
+        SplatFilm::Writer splats;
+
+        Context(SplatFilm &film, int depth) : cameraPath(depth + 1), lightPath(depth), splats(film) {}
+    };
+
+    /// @brief Restores a value once it goes out of scope.
+    template <typename T>
+    class ScopedAssignment {
+        T *m_target = nullptr;
+        T m_backup;
+
+    public:
+        ScopedAssignment(T *target, T value) : m_target(target) {
+            if (m_target) {
+                m_backup = *m_target;
+                *m_target = value;
+            }
+        }
+        ScopedAssignment(const ScopedAssignment &) = delete;
+        ~ScopedAssignment() {
+            if (m_target)
+                *m_target = m_backup;
+        }
+    };
+
+    const cref<Scene> m_scene;
+    /// @brief The maximal number of segments of a path.
+    const int m_depth;
+
+    /// @brief The light sources that light paths start at, and how often they are picked.
+    std::vector<const Light *> m_emitters;
+    AliasTable m_emitterSelection;
+    std::unordered_map<const Light *, size_t> m_emitterIndices;
+    /// @brief The light sources that are only found by camera paths, which are picked uniformly.
+    std::vector<const Light *> m_infiniteLights;
+
+    /// @brief The contributions of light tracing, which land on arbitrary pixels.
+    SplatFilm m_splats;
+
+    static float powerHeuristic(float f, float g) {
+        if (std::isfinite(sqr(f))) [[likely]]
+            return sqr(f) / (sqr(f) + sqr(g));
+        else
+            return 1;
+    }
+
+    /// @brief Returns the probability of starting a light path at a given light source.
+    float emitterProbability(const Light *light) const {
+        const auto it = m_emitterIndices.find(light);
+        return it == m_emitterIndices.end() ? 0 : m_emitterSelection.pdf(it->second);
+    }
+
+    /// @brief Converts a density in solid angle at one vertex to a density in area at another.
+    static float convertDensity(float pdf, const Vertex &from, const Vertex &to) {
+        const Vector w = to.position() - from.position();
+        const float distance2 = w.lengthSquared();
+        if (distance2 == 0)
+            return 0;
+        if (to.isOnSurface())
+            pdf *= std::abs(to.its.frame.normal.dot(w)) / std::sqrt(distance2);
+        return pdf / distance2;
+    }
+
+    /// @brief Returns the light source of a light vertex, or of the emissive surface a camera path has hit.
+    static const Light *lightOf(const Vertex &vertex) {
+        return vertex.type == Vertex::Type::Light ? vertex.light : vertex.its.instance->light();
+    }
+
+    /// @brief Returns the density of a light path starting at a vertex (which is on a light source).
+    float pdfLightOrigin(const Vertex &vertex, const Vertex &next) const {
+        const Light *light = lightOf(vertex);
+        const Vector direction = (next.position() - vertex.position()).normalized();
+        return emitterProbability(light) * light->pdfEmission(vertex.its, direction).position;
+    }
+
+    /// @brief Returns the density of a light path that starts at a vertex (which is on a light source) continuing at
+    /// another vertex.
+    float pdfLight(const Vertex &vertex, const Vertex &next) const {
+        const Vector direction = (next.position() - vertex.position()).normalized();
+        return convertDensity(lightOf(vertex)->pdfEmission(vertex.its, direction).direction, vertex, next);
+    }
+
+    /// @brief Returns the density of sampling @c next from a vertex that has been reached from @c prev .
+    float pdf(const Vertex &vertex, const Vertex *prev, const Vertex &next) const {
+        if (vertex.type == Vertex::Type::Light)
+            return pdfLight(vertex, next);
+
+        const Vector wn = (next.position() - vertex.position()).normalized();
+        float pdf;
+        if (vertex.type == Vertex::Type::Camera) {
+            pdf = m_scene->camera()->pdf(wn);
+        } else {
+            const Bsdf *bsdf = vertex.its.instance->bsdf();
+            if (!bsdf)
+                return 0;
+            const Vector wp = (prev->position() - vertex.position()).normalized();
+            pdf = bsdf->evaluate(vertex.its.uv, vertex.its.frame.toLocal(wp), vertex.its.frame.toLocal(wn)).pdf;
+        }
+        return convertDensity(pdf, vertex, next);
+    }
+
+    /**
+     * @brief Extends a path by sampling the BSDFs of the surfaces it hits, and returns its new number of vertices.
+     * @param importance Whether the path starts at a light source, whose BSDF samples must not scale radiance at
+     * refractive interfaces.
+     * @param escape Receives the ray that has left the scene, if any.
+     */
+    int walk(Vertex *path, int count, int maxCount, Ray ray, Color beta, float pdf, bool importance, Sampler &rng,
+             Escape *escape) const {
+        while (count < maxCount) {
+            Vertex &prev = path[count - 1];
+            const Intersection its = m_scene->intersect(ray, rng);
+            if (!its) {
+                if (escape)
+                    *escape = { .from = count - 1, .direction = ray.direction, .beta = beta, .pdf = pdf };
+                break;
+            }
+
+            Vertex &vertex = path[count++];
+            vertex.type = Vertex::Type::Surface;
+            vertex.delta = false;
+            vertex.its = its;
+            vertex.light = nullptr;
+            vertex.beta = beta;
+            vertex.pdfFwd = convertDensity(pdf, prev, vertex);
+            vertex.pdfRev = 0;
+            if (count == maxCount)
+                break;
+
+            const BsdfSample bs = its.sampleBsdf(rng);
+            if (bs.isInvalid())
+                break;
+            beta *= importance ? bs.weight * sqr(bs.eta) : bs.weight;
+
+            float pdfRev = 0;
+            if (bs.pdf == 0) {
+                vertex.delta = true;
+                pdf = 0;
+            } else {
+                pdf = bs.pdf;
+                pdfRev = its.instance->bsdf()
+                             ->evaluate(its.uv, its.frame.toLocal(bs.wi), its.frame.toLocal(its.wo))
+                             .pdf;
+            }
+            prev.pdfRev = convertDensity(pdfRev, vertex, prev);
+            ray = Ray(its.position, bs.wi);
+        }
+        return count;
+    }
+
+    /// @brief Traces a path from a randomly picked light source, and returns its number of vertices.
+    int traceLightPath(Vertex *path, Sampler &rng) const {
+        if (m_emitters.empty() || m_depth < 1)
+            return 0;
+        const Sample1D selection = m_emitterSelection.sample(rng.next());
+        const Light *light = m_emitters[selection.index];
+        const EmissionSample es = light->sampleEmission(rng);
+        if (es.isInvalid())
+            return 0;
+        const EmissionPdf emissionPdf = light->pdfEmission(es.surface, es.direction);
+
+        // the emitted radiance depends on the direction, and is evaluated when the vertex is connected to
+        Vertex &vertex = path[0];
+        vertex.type = Vertex::Type::Light;
+        vertex.delta = false;
+        vertex.its = Intersection();
+        static_cast<SurfaceEvent &>(vertex.its) = es.surface;
+        vertex.light = light;
+        vertex.beta = Color(1 / (selection.pdf * es.surface.pdf));
+        vertex.pdfFwd = selection.pdf * emissionPdf.position;
+        vertex.pdfRev = 0;
+        return walk(path,
+                    1,
+                    m_depth,
+                    Ray(es.surface.position, es.direction),
+                    es.weight / selection.pdf,
+                    emissionPdf.direction,
+                    true,
+                    rng,
+                    nullptr);
+    }
+
+    /// @brief Returns the radiance a light vertex emits, or the importance-weighted BSDF of a surface vertex of a
+    /// light path scatters, towards a direction (including the cosine at the vertex).
+    static Color lightPathValue(const Vertex &vertex, const Vector &direction) {
+        if (vertex.type == Vertex::Type::Light) {
+            Color emission = vertex.light->evaluateEmission(vertex.its, direction);
+            if (vertex.light->canBeIntersected())
+                emission *= std::abs(vertex.its.frame.normal.dot(direction));
+            return emission;
+        }
+        const BsdfEval be = vertex.its.evaluateBsdf(direction);
+        return be.value * sqr(be.eta);
+    }
+
+    /// @brief Computes the weight of the strategy that connects the first @c s vertices of the light path to the
+    /// first @c t vertices of the camera path, relative to all strategies that could have sampled the same path.
+    float misWeight(Vertex *light, int s, Vertex *camera, int t) const {
+        if (s + t == 2)
+            return 1;
+        Vertex *qs = s > 0 ? &light[s - 1] : nullptr;
+        Vertex *pt = &camera[t - 1];
+        Vertex *qsMinus = s > 1 ? &light[s - 2] : nullptr;
+        Vertex *ptMinus = t > 1 ? &camera[t - 2] : nullptr;
+        // emissive surfaces whose light source does not start light paths can only be found by camera paths
+        if (s == 0 && emitterProbability(pt->its.instance->light()) == 0)
+            return 1;
+
+        // temporarily change the vertices around the connection to what they are for this strategy
+        ScopedAssignment<bool> a1(&pt->delta, false);
+        ScopedAssignment<bool> a2(qs ? &qs->delta : nullptr, false);
+        ScopedAssignment<float> a3(t > 1 ? &pt->pdfRev : nullptr,
+                                   t > 1 ? (s > 0 ? pdf(*qs, qsMinus, *pt) : pdfLightOrigin(*pt, *ptMinus)) : 0);
+        ScopedAssignment<float> a4(ptMinus ? &ptMinus->pdfRev : nullptr,
+                                   ptMinus ? (s > 0 ? pdf(*pt, qs, *ptMinus) : pdfLight(*pt, *ptMinus)) : 0);
+        ScopedAssignment<float> a5(qs ? &qs->pdfRev : nullptr, qs ? pdf(*pt, ptMinus, *qs) : 0);
+        ScopedAssignment<float> a6(qsMinus ? &qsMinus->pdfRev : nullptr, qsMinus ? pdf(*qs, pt, *qsMinus) : 0);
+
+        // densities of zero belong to delta distributions, whose strategies are excluded below
+        const auto remap0 = [](float f) { return f != 0 ? f : 1; };
+
+        float sumRi = 0;
+        float ri = 1;
+        for (int i = t - 1; i > 0; i--) {
+            ri *= remap0(camera[i].pdfRev) / remap0(camera[i].pdfFwd);
+            if (!camera[i].delta && !camera[i - 1].delta)
+                sumRi += sqr(ri);
+        }
+        ri = 1;
+        for (int i = s - 1; i >= 0; i--) {
+            ri *= remap0(light[i].pdfRev) / remap0(light[i].pdfFwd);
+            const bool deltaBefore = i > 0 ? light[i - 1].delta : light[0].isDeltaLight();
+            if (!light[i].delta && !deltaBefore)
+                sumRi += sqr(ri);
+        }
+        return 1 / (1 + sumRi);
+    }
+
+    /**
+     * @brief Connects the first @c s vertices of the light path to the first @c t vertices of the camera path, and
+     * returns the weighted contribution of the resulting path.
+     * @param pixel Receives the pixel that light tracing connections (@c t = 1) contribute to.
+     */
+    Color connect(Vertex *light, int s, Vertex *camera, int t, Sampler &rng, Point2 &pixel) const {
+        Color L;
+        if (s == 0) {
+            const Vertex &pt = camera[t - 1];
+            if (!pt.isEmissive())
+                return Color(0);
+            L = pt.beta * pt.its.evaluateEmission();
+        } else if (t == 1) {
+            const Vertex &qs = light[s - 1];
+            if (qs.type != Vertex::Type::Surface)
+                return Color(0);
+            const CameraConnection cc = m_scene->camera()->connect(qs.position(), rng);
+            if (cc.isInvalid())
+                return Color(0);
+            L = qs.beta * lightPathValue(qs, cc.wi) * cc.weight;
+            if (L == Color(0))
+                return Color(0);
+            if (m_scene->intersect(Ray(qs.position(), cc.wi), cc.distance, rng))
+                return Color(0);
+            pixel = cc.pixel;
+        } else {
+            const Vertex &qs = light[s - 1];
+            const Vertex &pt = camera[t - 1];
+            Vector w = qs.position() - pt.position();
+            const float distance = w.length();
+            if (distance == 0)
+                return Color(0);
+            w /= distance;
+            const BsdfEval be = pt.its.evaluateBsdf(w);
+            if (be.isInvalid())
+                return Color(0);
+            L = pt.beta * be.value * lightPathValue(qs, -w) * qs.beta / sqr(distance);
+            if (L == Color(0))
+                return Color(0);
+            if (m_scene->intersect(Ray(pt.position(), w), distance, rng))
+                return Color(0);
+        }
+        return L * misWeight(light, s, camera, t);
+    }
+
+    /// @brief Returns the contribution of light sources that light paths do not start at to a camera path.
+    Color infiniteLights(const Vertex *camera, int count, const Escape &escape, Sampler &rng) const {
+        Color result;
+        if (escape.from >= 0) {
+            const BackgroundLightEval ble = m_scene->evaluateBackground(escape.direction);
+            // without a background, both pdfs are zero and the weight would be nan
+            if (!ble.isInvalid()) {
+                float w = 1;
+                if (escape.from > 0 && escape.pdf > 0) {
+                    w = powerHeuristic(escape.pdf * ble.sinTheta, infiniteProbability(m_scene->background()) * ble.pdf);
+                }
+                result += w * escape.beta * ble.value;
+            }
+        }
+
+        if (m_infiniteLights.empty())
+            return result;
+        const float probability = 1.f / m_infiniteLights.size();
+        for (int i = 1; i < std::min(count, m_depth); i++) {
+            const Vertex &vertex = camera[i];
+            const size_t index =
+                std::min(size_t(rng.next() * m_infiniteLights.size()), m_infiniteLights.size() - 1);
+            const Light *light = m_infiniteLights[index];
+            const DirectLightSample dls = light->sampleDirect(vertex.position(), rng);
+            if (dls.isInvalid())
+                continue;
+            const BsdfEval be = vertex.its.evaluateBsdf(dls.wi);
+            if (be.isInvalid())
+                continue;
+            if (m_scene->intersect(Ray(vertex.position(), dls.wi), dls.distance, rng, light))
+                continue;
+            const float w =
+                light->canBeIntersected() ? powerHeuristic(dls.pdf * probability, be.pdf * dls.cosTheta_o) : 1;
+            result += w * vertex.beta * be.value * dls.weight / probability;
+        }
+        return result;
+    }
+
+    float infiniteProbability(const Light *light) const {
+        if (std::find(m_infiniteLights.begin(), m_infiniteLights.end(), light) == m_infiniteLights.end())
+            return 0;
+        return 1.f / m_infiniteLights.size();
+    }
+
+    /// @brief Estimates the radiance along a camera ray, and splats the contributions of light tracing.
+    Color trace(const Ray &ray, Sampler &rng, Context &context) const {
+        Vertex *camera = context.cameraPath.data();
+        Vertex *light = context.lightPath.data();
+
+        camera[0].type = Vertex::Type::Camera;
+        camera[0].delta = false;
+        camera[0].its = Intersection();
+        camera[0].its.position = ray.origin;
+        camera[0].light = nullptr;
+        camera[0].beta = Color(1);
+        camera[0].pdfFwd = 0;
+        camera[0].pdfRev = 0;
+        Escape escape{ .from = -1 };
+        const int cameraCount =
+            walk(camera, 1, m_depth + 1, ray, Color(1), m_scene->camera()->pdf(ray.direction), false, rng, &escape);
+        const int lightCount = traceLightPath(light, rng);
+
+        Color result = infiniteLights(camera, cameraCount, escape, rng);
+        for (int t = 1; t <= cameraCount; t++) {
+            for (int s = 0; s <= lightCount; s++) {
+                // the camera cannot be hit, and light sources are connected to the camera only through surfaces
+                if (s + t - 1 > m_depth || (t == 1 && s < 2))
+                    continue;
+                Point2 pixel;
+                const Color L = connect(light, s, camera, t, rng, pixel);
+                if (L == Color(0))
+                    continue;
+                if (t == 1)
+                    context.splats.splat(pixel, L, m_scene->camera()->filter());
+                else
+                    result += L;
+            }
+        }
+        return result;
+    }
+
+protected:
+    int renderBlock(const Bounds2i &block, Sampler &sampler, int target, bool skipConverged) override {
+        Context context(m_splats, m_depth);
+        int taken = 0;
+        for (auto pixel : block) {
+            PixelEstimate &estimate = m_film(pixel);
+            for (int sample = estimate.count; sample < target; sample++) {
+                sampler.seed(pixel, options.sampleOffset + sample);
+                auto cameraSample = m_scene->camera()->sample(pixel, sampler);
+                estimate.add(cameraSample.weight * trace(cameraSample.ray, sampler, context));
+                recordAuxiliaryOutputs(pixel, cameraSample.ray, sampler);
+                taken++;
+            }
+        }
+        m_film.develop(*m_image, block);
+        return taken;
+    }
+
+    void finishImage() override {
+        const int64_t samples = m_film.totalSamples();
+        if (samples == 0)
+            return;
+        // light tracing splats estimate the image as a whole, so they are normalized by the average samples per pixel
+        const Point2i resolution = m_scene->camera()->resolution();
+        const float scale = float(resolution.x()) * resolution.y() / samples;
+        for (auto pixel : Bounds2i(Point2i(0), resolution))
+            (*m_image)(pixel) += scale * m_splats(pixel);
+    }
+
+public:
+    BidirectionalPathTracerIntegrator(const Properties &properties)
+        : SamplingIntegrator(properties),
+          m_scene(properties.getChild<Scene>("scene")),
+          m_depth(properties.get<int>("depth", 2)) {
+        std::vector<float> weights;
+        const Bounds bounds = m_scene->getBoundingBox();
+        for (const auto &light : m_scene->lights()) {
+            if (!light->supportsEmissionSampling()) {
+                m_infiniteLights.push_back(light.get());
+                continue;
+            }
+            m_emitterIndices[light.get()] = m_emitters.size();
+            m_emitters.push_back(light.get());
+            weights.push_back(light->power(bounds).luminance());
+        }
+        for (const float weight : weights) {
+            if (!std::isfinite(weight) || weight < 0) {
+                logger(EWarn, "could not estimate the power of all lights, falling back to uniform light selection");
+                std::fill(weights.begin(), weights.end(), 1.f);
+                break;
+            }
+        }
+        if (!m_emitters.empty())
+            m_emitterSelection = AliasTable(weights);
+    }
+
+    void execute() override {
+        if (!m_scene->camera()->supportsConnections())
+            lightwave_throw("the bdpt integrator requires a camera that light paths can be connected to");
+        if (m_adaptive || m_checkpointInterval > 0 || options.resume || !options.partial.empty())
+            lightwave_throw("the bdpt integrator does not support adaptive sampling, checkpoints or partial renders, "
+                            "as light tracing contributes to arbitrary pixels");
+        m_splats.initialize(m_scene->camera()->resolution());
+        SamplingIntegrator::execute();
+    }
+
+    Color Li(const Ray &ray, Sampler &rng) override {
+        // rendering goes through renderBlock, which shares these buffers among all samples of a block
+        Context context(m_splats, m_depth);
+        return trace(ray, rng, context);
+    }
+
+    /// @brief An optional textual representation of this class, which can be useful for debugging.
+    std::string toString() const override {
+        return tfm::format(
+            "BidirectionalPathTracerIntegrator[\n"
+            "  depth = %d\n"
+            "  sampler = %s,\n"
+            "  image = %s,\n"
+            "]",
+            m_depth,
+            indent(m_sampler),
+            indent(m_image));
+    }
+};
+
+}
+
+REGISTER_INTEGRATOR(BidirectionalPathTracerIntegrator, "bdpt")
@@ -3,15 +3,33 @@
 #include "lightwave/light.hpp"
 #include "lightwave/registry.hpp"
 
+#include "resampling.hpp"
+
 namespace lightwave {
 
+/**
+ * @brief Computes direct lighting at the first surface a camera ray hits. Light sources that cannot be hit by rays
+ * (point and directional lights) are sampled explicitly, while all others are found by sampling the BSDF.
+ *
+ * With more than one light candidate (see @ref LightResampler ), all light sources are sampled explicitly, and combined
+ * with BSDF sampling by multiple importance sampling as in the "mispathtracer" integrator.
+ */
 class DirectIntegrator final : public SamplingIntegrator {
     const cref<Scene> m_scene;
+    const LightResampler m_resampler;
+
+    float powerHeuristic(float f, float g) {
+        if (std::isfinite(sqr(f))) [[likely]]
+            return sqr(f) / (sqr(f) + sqr(g));
+        else
+            return 1;
+    }
 
 public:
     DirectIntegrator(const Properties &properties)
         : SamplingIntegrator(properties),
-          m_scene(properties.getChild<Scene>("scene")) {}
+          m_scene(properties.getChild<Scene>("scene")),
+          m_resampler(properties) {}
 
     Color Li(const Ray &ray, Sampler &rng) override {
         Intersection its = m_scene->intersect(ray, rng);
@@ -21,36 +39,43 @@ public:
             return its.evaluateEmission();
 
         Color bsdf_color = Color::black(), light_color = Color::black();
-        LightSample ls;
-        DirectLightSample dls;
-        BsdfEval be;
+        const bool mis = m_resampler.enabled();
+        ResampledLightSample rls;
         BsdfSample bs;
+        BackgroundLightEval ble;
+        const Point origin = its.position;
 
-        if (not m_scene->hasLights())
-            goto cont;
-        ls = m_scene->sampleLight(rng);
-        if (ls.light->canBeIntersected())
+        rls = m_resampler.sample(*m_scene, its, rng, mis);
+        if (rls.isInvalid())
             goto cont;
-        dls = ls.light->sampleDirect(its.position, rng);
-        if (dls.isInvalid()) [[unlikely]]
+        if (m_scene->intersect(Ray(its.position, rls.dls.wi), rls.dls.distance, rng, rls.light))
             goto cont;
-        if (m_scene->intersect(Ray(its.position, dls.wi), dls.distance, rng))
-            goto cont;
-        be = its.evaluateBsdf(dls.wi);
-        if (be.isInvalid()) [[unlikely]]
-            goto cont;
-        light_color += be.value * dls.weight / ls.probability;
+        light_color += rls.weight;
+        if (mis && rls.light->canBeIntersected())
+            light_color *= powerHeuristic(rls.dls.pdf * rls.probability, rls.be.pdf * rls.dls.cosTheta_o);
     cont:
         bs = its.sampleBsdf(rng);
         if (bs.isInvalid())
             return light_color;
-        its = m_scene->intersect(Ray(its.position, bs.wi), rng);
-        if (not its)
-            bsdf_color += bs.weight * m_scene->evaluateBackground(bs.wi).value;
-        else if (its.instance->emission()) {
+        its = m_scene->intersect(Ray(origin, bs.wi), rng);
+        if (not its) {
+            ble = m_scene->evaluateBackground(bs.wi);
+            // without a background, both pdfs are zero and the weight would be nan
+            if (ble.isInvalid())
+                return light_color;
+            const float w = mis ? powerHeuristic(bs.pdf * ble.sinTheta,
+                                                 m_scene->lightSelectionProbability(m_scene->background(), origin) *
+                                                     ble.pdf)
+                                : 1;
+            bsdf_color += w * bs.weight * ble.value;
+        } else if (its.instance->emission()) {
             auto light = its.instance->light();
             if (not light)
                 bsdf_color += bs.weight * its.evaluateEmission();
+            else if (mis)
+                bsdf_color += powerHeuristic(bs.pdf * its.frame.normal.dot(its.wo),
+                                             m_scene->lightSelectionProbability(light, origin) * its.pdf * sqr(its.t)) *
+                              bs.weight * its.evaluateEmission();
         }
 
         return light_color + bsdf_color;
@@ -60,9 +85,11 @@ public:
     std::string toString() const override {
         return tfm::format(
             "DirectIntegrator[\n"
+            "  resampler = %s\n"
             "  sampler = %s,\n"
             "  image = %s,\n"
             "]",
+            m_resampler.toString(),
             indent(m_sampler),
             indent(m_image));
     }
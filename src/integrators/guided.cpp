@@ -0,0 +1,295 @@
+#include "lightwave/camera.hpp"
+#include "lightwave/instance.hpp"
+#include "lightwave/integrator.hpp"
+#include "lightwave/iterators.hpp"
+#include "lightwave/light.hpp"
+#include "lightwave/parallel.hpp"
+#include "lightwave/registry.hpp"
+
+#include "roulette.hpp"
+#include "sdtree.hpp"
+
+namespace lightwave {
+
+/**
+ * @brief A path tracer that learns where light comes from and steers its paths there (Müller et al., "Practical Path
+ * Guiding for Efficient Light-Transport Simulation", 2017).
+ *
+ * Before rendering, the integrator traces a number of training iterations whose sample counts double every time.
+ * Each iteration records the incident radiance found along its paths into an @ref SDTree , and samples directions
+ * from what the previous iteration has learned. Directions are picked from the learned distribution or the BSDF with
+ * a fixed probability, and weighted by the mixture of both densities. The image is then rendered with the final
+ * distribution, which is no longer updated. Next event estimation is combined with both strategies by MIS, as in the
+ * "mispathtracer" integrator.
+ */
+class GuidedPathTracerIntegrator final : public SamplingIntegrator {
+    /// @brief The largest depth of the directional quadtrees.
+    static constexpr int MaxDirectionalDepth = 20;
+    /// @brief The largest number of vertices per path whose incident radiance is recorded during training.
+    static constexpr int MaxRecordedVertices = 32;
+
+    const cref<Scene> m_scene;
+    const int m_depth;
+    const RussianRoulette m_roulette;
+
+    /// @brief The number of training iterations.
+    const int m_trainingIterations;
+    /// @brief The samples per pixel of the first training iteration, which doubles with every iteration.
+    const int m_trainingSamples;
+    /// @brief The number of samples a spatial leaf needs to be split, multiplied by the root of the samples per pixel.
+    const float m_spatialThreshold;
+    /// @brief The fraction of the energy of a directional quadtree above which its quadrants are subdivided.
+    const float m_directionalThreshold;
+    /// @brief The probability of sampling the BSDF rather than the learned distribution.
+    const float m_bsdfSamplingFraction;
+
+    SDTree m_sdtree;
+    /// @brief Whether the learned distributions should be sampled (i.e., at least one iteration has finished).
+    bool m_guiding = false;
+    /// @brief Whether paths record their incident radiance.
+    bool m_training = false;
+
+    /// @brief A vertex of a path whose incident radiance is recorded once the path is complete.
+    struct Vertex {
+        QuadTree *tree;
+        Point2 direction;
+        /// @brief The path throughput including the sampling weight at this vertex.
+        Color throughput;
+        /// @brief The radiance arriving at this vertex from the sampled direction.
+        Color radiance;
+        /// @brief The density the direction was sampled with.
+        float pdf;
+
+        void addContribution(const Color &contribution) {
+            for (int channel = 0; channel < Color::NumComponents; channel++) {
+                if (throughput[channel] > 0)
+                    radiance[channel] += contribution[channel] / throughput[channel];
+            }
+        }
+    };
+
+    float powerHeuristic(float f, float g) {
+        if (std::isfinite(sqr(f))) [[likely]]
+            return sqr(f) / (sqr(f) + sqr(g));
+        else
+            return 1;
+    }
+
+    /// @brief Returns the density of sampling a direction at a vertex, combining the BSDF and the learned distribution.
+    float mixturePdf(const SDTree::Leaf *leaf, float bsdfPdf, const Vector &direction) const {
+        if (!leaf)
+            return bsdfPdf;
+        const float guidePdf = leaf->sampling.pdf(directionToCanonical(direction)) * Inv4Pi;
+        return m_bsdfSamplingFraction * bsdfPdf + (1 - m_bsdfSamplingFraction) * guidePdf;
+    }
+
+    /// @brief Renders the image once with a given number of samples per pixel, discarding the result.
+    void trainingIteration(int samplesPerPixel, int sampleOffset) {
+        const Vector2i resolution = m_scene->camera()->resolution();
+        const auto cloneSampler = [&] { return m_sampler->clone(); };
+        for_each_parallel(BlockSpiral(resolution, Vector2i(64)), cloneSampler, [&](auto block, ref<Sampler> &sampler) {
+            for (auto pixel : block) {
+                for (int sample = 0; sample < samplesPerPixel; sample++) {
+                    sampler->seed(pixel, sampleOffset + sample);
+                    auto cameraSample = m_scene->camera()->sample(pixel, *sampler);
+                    Li(cameraSample.ray, *sampler);
+                }
+            }
+        });
+    }
+
+public:
+    GuidedPathTracerIntegrator(const Properties &properties)
+        : SamplingIntegrator(properties),
+          m_scene(properties.getChild<Scene>("scene")),
+          m_depth(properties.get<int>("depth", 2)),
+          m_roulette(properties),
+          m_trainingIterations(properties.get<int>("trainingIterations", 6)),
+          m_trainingSamples(std::max(properties.get<int>("trainingSamples", 1), 1)),
+          m_spatialThreshold(properties.get<float>("spatialThreshold", 12000)),
+          m_directionalThreshold(properties.get<float>("directionalThreshold", 0.01f)),
+          m_bsdfSamplingFraction(std::clamp(properties.get<float>("bsdfSamplingFraction", 0.5f), 0.f, 1.f)) {}
+
+    void execute() override {
+        m_sdtree = SDTree(m_scene->getBoundingBox());
+        m_guiding = false;
+
+        // training samples continue the sequences of the pixels after the samples of the image, so that they are
+        // independent of them
+        int sampleOffset = options.sampleOffset + std::max(options.sampleCount, m_sampler->samplesPerPixel());
+        Timer trainingTimer;
+        m_training = true;
+        for (int iteration = 0; iteration < m_trainingIterations; iteration++) {
+            const int samplesPerPixel = m_trainingSamples << iteration;
+            trainingIteration(samplesPerPixel, sampleOffset);
+            sampleOffset += samplesPerPixel;
+
+            m_sdtree.refine(int64_t(m_spatialThreshold * std::sqrt(float(samplesPerPixel))),
+                            m_directionalThreshold,
+                            MaxDirectionalDepth);
+            m_guiding = true;
+        }
+        m_training = false;
+        logger(EInfo,
+               "trained guiding distribution in %d iterations (%.2fs): %ld spatial leaves, %ld directional nodes",
+               m_trainingIterations,
+               trainingTimer.getElapsedTime(),
+               m_sdtree.leafCount(),
+               m_sdtree.directionalNodeCount());
+
+        SamplingIntegrator::execute();
+    }
+
+    Color Li(const Ray &ray, Sampler &rng) override {
+        Intersection its;
+        Color bsdf_color;
+        Color light_color;
+        Color weight = Color::white();
+        LightSample ls;
+        DirectLightSample dls;
+        BsdfEval be;
+        BsdfSample bs;
+        BackgroundLightEval ble;
+        float w;
+
+        Vertex vertices[MaxRecordedVertices];
+        int vertexCount = 0;
+        // adds a contribution to the image and to the incident radiance of all vertices recorded so far
+        const auto contribute = [&](Color &target, const Color &contribution) {
+            target += contribution;
+            for (int i = 0; i < vertexCount; i++)
+                vertices[i].addContribution(contribution);
+        };
+
+        its = m_scene->intersect(ray, rng);
+        if (not its)
+            return m_scene->evaluateBackground(ray.direction).value;
+        if (its.instance->emission())
+            return its.evaluateEmission();
+
+        for (int depth = 1; depth < m_depth; depth++) {
+            SDTree::Leaf *leaf = m_guiding || m_training ? &m_sdtree.lookup(its.position) : nullptr;
+            // the distribution of the first iteration has not learned anything yet
+            SDTree::Leaf *guide = m_guiding && leaf->sampling.total() > 0 ? leaf : nullptr;
+
+            if (not m_scene->hasLights())
+                goto cont;
+            ls = m_scene->sampleLight(its.position, rng);
+            if (ls.isInvalid())
+                goto cont;
+            dls = ls.light->sampleDirect(its.position, rng);
+            if (dls.isInvalid())
+                goto cont;
+            if (m_scene->intersect(
+                    Ray(its.position, dls.wi), dls.distance, rng))
+                goto cont;
+            be = its.evaluateBsdf(dls.wi);
+            if (be.isInvalid()) [[unlikely]]
+                goto cont;
+            w = ls.light->canBeIntersected()
+                    ? powerHeuristic(dls.pdf * ls.probability,
+                                     mixturePdf(guide, be.pdf, dls.wi) * dls.cosTheta_o)
+                    : 1;
+            contribute(light_color, w * weight * be.value * dls.weight / ls.probability);
+        cont:
+            bs = its.sampleBsdf(rng);
+            if (bs.isInvalid()) [[unlikely]]
+                break;
+
+            // specular BSDFs (whose samples have no density) cannot be guided
+            float pdf = bs.pdf;
+            if (guide && bs.pdf > 0) {
+                if (rng.next() >= m_bsdfSamplingFraction) {
+                    float guidePdf;
+                    bs.wi = canonicalToDirection(guide->sampling.sample(rng.next2D(), guidePdf));
+                    be = its.evaluateBsdf(bs.wi);
+                    if (be.isInvalid())
+                        break;
+                    bs.weight = be.value;
+                    bs.pdf = be.pdf;
+                } else {
+                    bs.weight *= bs.pdf;
+                }
+                pdf = mixturePdf(guide, bs.pdf, bs.wi);
+                if (!(pdf > 0))
+                    break;
+                bs.weight /= pdf;
+            }
+            weight *= bs.weight;
+
+            if (m_training && bs.pdf > 0 && vertexCount < MaxRecordedVertices) {
+                vertices[vertexCount++] = {
+                    .tree = &leaf->building,
+                    .direction = directionToCanonical(bs.wi),
+                    .throughput = weight,
+                    .radiance = Color(0),
+                    .pdf = pdf,
+                };
+            }
+
+            if (not m_roulette.survive(depth, weight, rng))
+                break;
+            auto r = Ray(its.position, bs.wi);
+            its = m_scene->intersect(r, rng);
+            if (not its) {
+                ble = m_scene->evaluateBackground(r.direction);
+                // without a background, both pdfs are zero and the weight would be nan
+                if (ble.isInvalid())
+                    break;
+                w = powerHeuristic(
+                    pdf * ble.sinTheta,
+                    m_scene->lightSelectionProbability(m_scene->background(), r.origin) * ble.pdf);
+                // the learned distribution follows all light arriving from the sampled direction, not just its share
+                // under MIS
+                if (vertexCount > 0)
+                    vertices[vertexCount - 1].radiance += ble.value * (1 - w);
+                contribute(bsdf_color, w * weight * ble.value);
+                break;
+            } else if (its.instance->emission()) {
+                auto light = its.instance->light();
+                if (light) {
+                    auto cosTheta_o = its.frame.normal.dot(its.wo);
+                    auto pl = m_scene->lightSelectionProbability(light, r.origin) *
+                              its.pdf * sqr(its.t);
+                    w = powerHeuristic(pdf * cosTheta_o, pl);
+                } else {
+                    w = 1;
+                }
+                const Color emission = its.evaluateEmission();
+                if (vertexCount > 0)
+                    vertices[vertexCount - 1].radiance += emission * (1 - w);
+                contribute(bsdf_color, w * weight * emission);
+                break;
+            }
+        }
+
+        for (int i = 0; i < vertexCount; i++)
+            vertices[i].tree->record(vertices[i].direction, vertices[i].radiance.luminance() / vertices[i].pdf);
+        return bsdf_color + light_color;
+    }
+
+    /// @brief An optional textual representation of this class, which can be useful for debugging.
+    std::string toString() const override {
+        return tfm::format(
+            "GuidedPathTracerIntegrator[\n"
+            "  depth = %d\n"
+            "  roulette = %s\n"
+            "  trainingIterations = %d\n"
+            "  trainingSamples = %d\n"
+            "  bsdfSamplingFraction = %f\n"
+            "  sampler = %s,\n"
+            "  image = %s,\n"
+            "]",
+            m_depth,
+            m_roulette.toString(),
+            m_trainingIterations,
+            m_trainingSamples,
+            m_bsdfSamplingFraction,
+            indent(m_sampler),
+            indent(m_image));
+    }
+};
+
+}
+
+REGISTER_INTEGRATOR(GuidedPathTracerIntegrator, "guided")
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <lightwave/core.hpp>
+#include <lightwave/math.hpp>
+#include <lightwave/parallel.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <ranges>
+#include <vector>
+
+namespace lightwave {
+
+/**
+ * @brief A uniform grid over a set of points (e.g., photons), whose cells are hashed into a table of buckets so that
+ * memory is proportional to the number of points rather than the extent of the scene.
+ *
+ * The grid is rebuilt from scratch by a parallel counting sort: points are counted per bucket with atomic increments,
+ * the counts are turned into bucket offsets, and points are scattered into their buckets. Each bucket is sorted by
+ * point index afterwards, so that lookups visit points in the same order regardless of how threads were scheduled.
+ * All buffers keep their capacity across rebuilds, so that rebuilding a grid of similar size does not allocate.
+ */
+class HashGrid {
+    /// @brief The number of points each work item of the parallel build processes.
+    static constexpr size_t ChunkSize = 4096;
+    /// @brief Marks points that are not part of the grid.
+    static constexpr uint32_t Skipped = uint32_t(-1);
+
+    float m_cellSize = 1;
+    /// @brief The cell of each point.
+    std::vector<Vector3i> m_cells;
+    /// @brief The bucket of each point.
+    std::vector<uint32_t> m_buckets;
+    /// @brief The offset of the first point of each bucket in @ref m_indices , followed by the total number of points.
+    std::vector<uint32_t> m_offsets;
+    /// @brief The next free slot of each bucket while scattering.
+    std::vector<uint32_t> m_cursors;
+    /// @brief The indices of all points, sorted by bucket.
+    std::vector<uint32_t> m_indices;
+
+    Vector3i cell(const Point &point) const {
+        return Vector3i(int(std::floor(point.x() / m_cellSize)),
+                        int(std::floor(point.y() / m_cellSize)),
+                        int(std::floor(point.z() / m_cellSize)));
+    }
+
+    uint32_t bucket(const Vector3i &cell) const {
+        uint64_t hash = hashMix(0, uint32_t(cell.x()));
+        hash = hashMix(hash, uint32_t(cell.y()));
+        hash = hashMix(hash, uint32_t(cell.z()));
+        return uint32_t(hash % (m_offsets.size() - 1));
+    }
+
+    /// @brief Invokes @c f for the index range of each chunk of a number of items, in parallel.
+    template <typename F>
+    static void forEachChunk(size_t count, F f) {
+        const size_t chunks = (count + ChunkSize - 1) / ChunkSize;
+        for_each_parallel(std::views::iota(size_t(0), chunks), [&](size_t chunk) {
+            f(chunk * ChunkSize, std::min((chunk + 1) * ChunkSize, count));
+        });
+    }
+
+public:
+    /**
+     * @brief Rebuilds the grid over a number of points.
+     * @param cellSize The edge length of the cells, which should be close to the radius of queries (larger cells
+     * report more points outside of the query, smaller cells require visiting more cells).
+     * @param position Invoked with the index of each point, returns whether the point should be part of the grid and
+     * if so writes its position to the second argument.
+     */
+    template <typename PositionFunction>
+    void build(size_t count, float cellSize, PositionFunction position) {
+        m_cellSize = cellSize;
+        m_cells.resize(count);
+        m_buckets.resize(count);
+        m_offsets.assign(std::max(count, size_t(1)) + 1, 0);
+
+        forEachChunk(count, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                Point point;
+                if (!position(i, point)) {
+                    m_buckets[i] = Skipped;
+                    continue;
+                }
+                m_cells[i] = cell(point);
+                m_buckets[i] = bucket(m_cells[i]);
+                std::atomic_ref<uint32_t>(m_offsets[m_buckets[i]])++;
+            }
+        });
+
+        uint32_t total = 0;
+        for (uint32_t &offset : m_offsets) {
+            const uint32_t bucketCount = offset;
+            offset = total;
+            total += bucketCount;
+        }
+
+        m_cursors.assign(m_offsets.begin(), m_offsets.end() - 1);
+        m_indices.resize(total);
+        forEachChunk(count, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                if (m_buckets[i] != Skipped)
+                    m_indices[std::atomic_ref<uint32_t>(m_cursors[m_buckets[i]])++] = uint32_t(i);
+            }
+        });
+
+        const size_t bucketCount = m_offsets.size() - 1;
+        forEachChunk(bucketCount, [&](size_t begin, size_t end) {
+            for (size_t b = begin; b < end; b++)
+                std::sort(m_indices.begin() + m_offsets[b], m_indices.begin() + m_offsets[b + 1]);
+        });
+    }
+
+    /**
+     * @brief Invokes @c f with the index of every point in the cells that overlap a sphere (which may include points
+     * outside of the sphere).
+     */
+    template <typename F>
+    void query(const Point &center, float radius, F f) const {
+        const Vector3i lower = cell(center - Vector(radius));
+        const Vector3i upper = cell(center + Vector(radius));
+        for (int z = lower.z(); z <= upper.z(); z++) {
+            for (int y = lower.y(); y <= upper.y(); y++) {
+                for (int x = lower.x(); x <= upper.x(); x++) {
+                    const Vector3i current(x, y, z);
+                    const uint32_t b = bucket(current);
+                    // several cells may share a bucket, hence only report points that lie in the current cell
+                    for (uint32_t i = m_offsets[b]; i < m_offsets[b + 1]; i++) {
+                        if (m_cells[m_indices[i]] == current)
+                            f(m_indices[i]);
+                    }
+                }
+            }
+        }
+    }
+};
+
+}
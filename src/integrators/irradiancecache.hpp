@@ -0,0 +1,302 @@
+/**
+ * @brief An irradiance cache for diffuse indirect lighting in the path tracing integrators.
+ * @file irradiancecache.hpp
+ */
+
+#pragma once
+
+#include <lightwave/color.hpp>
+#include <lightwave/core.hpp>
+#include <lightwave/math.hpp>
+#include <lightwave/properties.hpp>
+#include <lightwave/sampler.hpp>
+
+#include <array>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace lightwave {
+
+/**
+ * @brief Caches the indirect irradiance arriving at diffuse surfaces, so that it can be interpolated instead of being
+ * estimated by tracing paths at every shading point (Ward et al., "A Ray Tracing Solution for Diffuse
+ * Interreflection", 1988).
+ *
+ * Each record estimates the irradiance at a point by stratified sampling of the cosine-weighted hemisphere, along
+ * with its translational and rotational gradients (Ward and Heckbert, "Irradiance Gradients", 1992), which are
+ * derived from the radiance and distance found in neighbouring strata. A record is valid within a radius given by the
+ * harmonic mean of the distances to the surrounding geometry, limited by the magnitude of its translational gradient
+ * and clamped to a configurable range. Lookups blend all records whose error estimate (combining distance relative to
+ * the radius and the change of normal) stays below a threshold, and fail if there are none.
+ *
+ * Records are kept in a hierarchy of uniform grids whose cells are hashed: each record is entered into the cells that
+ * overlap its region of validity on the level whose cells are at least as large as that region, so that a lookup
+ * only visits one cell per level. Insertions and lookups can happen concurrently from any number of threads.
+ */
+class IrradianceCache {
+public:
+    /// @brief The irradiance at a point, along with the information needed to extrapolate it to nearby points.
+    struct Record {
+        Point position;
+        Vector normal;
+        Color irradiance;
+        /// @brief The radius within which the record can be used (before scaling by the error threshold).
+        float radius;
+        /// @brief The change of irradiance with the position, per color channel.
+        std::array<Vector, Color::NumComponents> translational;
+        /// @brief The change of irradiance with the rotation of the normal (as axis times angle), per color channel.
+        std::array<Vector, Color::NumComponents> rotational;
+    };
+
+private:
+    struct Key {
+        int level;
+        Vector3i cell;
+
+        bool operator==(const Key &other) const { return level == other.level && cell == other.cell; }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &key) const {
+            uint64_t hash = hashMix(0, uint32_t(key.level));
+            hash = hashMix(hash, uint32_t(key.cell.x()));
+            hash = hashMix(hash, uint32_t(key.cell.y()));
+            return hashMix(hash, uint32_t(key.cell.z()));
+        }
+    };
+
+    /// @brief The largest number of levels of the grid hierarchy.
+    static constexpr int MaxLevels = 24;
+
+    bool m_enabled;
+    /// @brief The vertex of paths (counted from the camera) at which the cache is used.
+    int m_depth;
+    /// @brief The largest error estimate of records that are used, where lower values require more records.
+    float m_error;
+    /// @brief The number of strata of the hemisphere along the polar and azimuthal angles.
+    int m_thetaStrata, m_phiStrata;
+    /// @brief The range of radii of records, where 0 picks a fraction of the scene size.
+    float m_minRadiusProperty, m_maxRadiusProperty;
+
+    float m_minRadius = 0, m_maxRadius = 0;
+    /// @brief The edge length of the cells of the finest level.
+    float m_cellSize = 1;
+    /// @brief The bit of each level that contains at least one record.
+    uint32_t m_levels = 0;
+    std::vector<Record> m_records;
+    std::unordered_map<Key, std::vector<uint32_t>, KeyHash> m_cells;
+    mutable std::shared_mutex m_mutex;
+
+    Vector3i cell(const Point &point, float cellSize) const {
+        return Vector3i(int(std::floor(point.x() / cellSize)),
+                        int(std::floor(point.y() / cellSize)),
+                        int(std::floor(point.z() / cellSize)));
+    }
+
+    /// @brief Returns the direction of the polar and azimuthal angles in the local frame of a surface.
+    static Vector direction(float sinTheta, float phi) {
+        const float cosTheta = safe_sqrt(1 - sqr(sinTheta));
+        return Vector(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+    }
+
+public:
+    IrradianceCache(const Properties &properties) {
+        m_enabled = properties.get<bool>("irradianceCache", false);
+        m_depth = std::max(properties.get<int>("cacheDepth", 2), 1);
+        m_error = std::max(properties.get<float>("cacheError", 0.3f), 1e-3f);
+        // as in Ward's paper, use about pi times as many azimuthal as polar strata
+        const int samples = std::max(properties.get<int>("cacheSamples", 256), 1);
+        m_thetaStrata = std::max(int(std::round(std::sqrt(samples / Pi))), 1);
+        m_phiStrata = std::max(samples / m_thetaStrata, 1);
+        m_minRadiusProperty = properties.get<float>("cacheMinRadius", 0);
+        m_maxRadiusProperty = properties.get<float>("cacheMaxRadius", 0);
+    }
+
+    /// @brief Whether the cache should be used at all.
+    bool enabled() const { return m_enabled; }
+    /// @brief The vertex of paths (counted from the camera, starting at 1) at which the cache is used.
+    int depth() const { return m_depth; }
+    /// @brief The number of records in the cache.
+    size_t size() const {
+        std::shared_lock lock(m_mutex);
+        return m_records.size();
+    }
+
+    /// @brief Removes all records and derives the default range of radii from the size of the scene.
+    void reset(const Bounds &sceneBounds) {
+        std::unique_lock lock(m_mutex);
+        const float diagonal = sceneBounds.diagonal().length();
+        m_minRadius = m_minRadiusProperty > 0 ? m_minRadiusProperty : 0.002f * diagonal;
+        m_maxRadius = std::max(m_maxRadiusProperty > 0 ? m_maxRadiusProperty : 0.1f * diagonal, m_minRadius);
+        m_cellSize = 2 * m_error * m_minRadius;
+        m_levels = 0;
+        m_records.clear();
+        m_cells.clear();
+    }
+
+    /**
+     * @brief Estimates a record at a surface point.
+     * @param frame The shading frame of the surface, whose normal the irradiance is computed for.
+     * @param incident Invoked with rays leaving the surface, returns the radiance arriving along them (excluding
+     * whatever is not meant to be cached, e.g. direct lighting) and writes the distance of the first surface hit
+     * (or infinity) to its second argument.
+     */
+    template <typename IncidentFunction>
+    Record compute(const Point &position, const Frame &frame, Sampler &rng, IncidentFunction incident) const {
+        const int M = m_thetaStrata, N = m_phiStrata;
+        std::vector<Color> radiance(M * N);
+        std::vector<float> distance(M * N);
+
+        Record record {
+            .position = position,
+            .normal = frame.normal,
+            .irradiance = Color(0),
+        };
+        float inverseDistanceSum = 0;
+        std::array<Vector, Color::NumComponents> rotational;
+        rotational.fill(Vector(0));
+        for (int j = 0; j < M; j++) {
+            for (int k = 0; k < N; k++) {
+                const Point2 u = rng.next2D();
+                // strata are uniform in sin^2(theta), which makes their cosine-weighted solid angles equal
+                const float sinTheta = std::sqrt((j + u.x()) / M);
+                const float phi = 2 * Pi * (k + u.y()) / N;
+                const Vector local = direction(sinTheta, phi);
+                const int index = j * N + k;
+                radiance[index] = incident(Ray(position, frame.toWorld(local)), distance[index]);
+                if (!std::isfinite(radiance[index])) [[unlikely]]
+                    radiance[index] = Color(0);
+
+                record.irradiance += radiance[index];
+                inverseDistanceSum += 1 / distance[index];
+                // rotating the normal about an axis changes cos(theta) along the azimuthal direction
+                const Vector azimuthal = Vector(-std::sin(phi), std::cos(phi), 0) * (sinTheta / local.z());
+                for (int channel = 0; channel < Color::NumComponents; channel++)
+                    rotational[channel] += radiance[index][channel] * azimuthal;
+            }
+        }
+        const float strataWeight = Pi / (M * N);
+        record.irradiance *= strataWeight;
+
+        // the translational gradient accounts for how the boundaries between strata sweep across the surrounding
+        // geometry as the point moves, using the closer of the two surfaces on either side of each boundary
+        std::array<Vector, Color::NumComponents> translational;
+        translational.fill(Vector(0));
+        for (int k = 0; k < N; k++) {
+            const float phi = 2 * Pi * k / N;
+            const Vector azimuthal = Vector(-std::sin(phi), std::cos(phi), 0);
+            const Vector radial = direction(1, phi + Pi / N);
+            for (int j = 0; j < M; j++) {
+                const int index = j * N + k;
+                if (j > 0) {
+                    const float sin2Theta = float(j) / M;
+                    const float factor = 2 * Pi / N * std::sqrt(sin2Theta) * (1 - sin2Theta) /
+                                         std::min(distance[index], distance[index - N]);
+                    for (int channel = 0; channel < Color::NumComponents; channel++)
+                        translational[channel] +=
+                            factor * (radiance[index][channel] - radiance[index - N][channel]) * radial;
+                }
+                const int previous = j * N + (k + N - 1) % N;
+                const float factor = (std::sqrt(float(j + 1) / M) - std::sqrt(float(j) / M)) /
+                                     std::min(distance[index], distance[previous]);
+                for (int channel = 0; channel < Color::NumComponents; channel++)
+                    translational[channel] +=
+                        factor * (radiance[index][channel] - radiance[previous][channel]) * azimuthal;
+            }
+        }
+
+        for (int channel = 0; channel < Color::NumComponents; channel++) {
+            record.translational[channel] = frame.toWorld(translational[channel]);
+            record.rotational[channel] = frame.toWorld(rotational[channel] * strataWeight);
+        }
+
+        // a large gradient means the irradiance changes quickly, which the extrapolation cannot follow for long
+        float radius = inverseDistanceSum > 0 ? M * N / inverseDistanceSum : Infinity;
+        float gradient = 0;
+        for (int channel = 0; channel < Color::NumComponents; channel++)
+            gradient = std::max(gradient, record.translational[channel].length());
+        if (gradient > 0)
+            radius = std::min(radius, record.irradiance.maxComponent() / gradient);
+        record.radius = std::clamp(radius, m_minRadius, m_maxRadius);
+        return record;
+    }
+
+    /// @brief Adds a record to the cache.
+    void insert(const Record &record) {
+        const float extent = m_error * record.radius;
+        int level = 0;
+        while (level < MaxLevels - 1 && m_cellSize * float(1 << level) < 2 * extent)
+            level++;
+        const float cellSize = m_cellSize * float(1 << level);
+        const Vector3i lower = cell(record.position - Vector(extent), cellSize);
+        const Vector3i upper = cell(record.position + Vector(extent), cellSize);
+
+        std::unique_lock lock(m_mutex);
+        const uint32_t index = uint32_t(m_records.size());
+        m_records.push_back(record);
+        m_levels |= 1u << level;
+        for (int z = lower.z(); z <= upper.z(); z++) {
+            for (int y = lower.y(); y <= upper.y(); y++) {
+                for (int x = lower.x(); x <= upper.x(); x++)
+                    m_cells[Key { level, Vector3i(x, y, z) }].push_back(index);
+            }
+        }
+    }
+
+    /**
+     * @brief Interpolates the irradiance at a surface point from the records nearby.
+     * @return The irradiance, or nothing if no record is close enough.
+     */
+    std::optional<Color> lookup(const Point &position, const Vector &normal) const {
+        Color irradiance(0);
+        float weightSum = 0;
+
+        std::shared_lock lock(m_mutex);
+        for (int level = 0; level < MaxLevels; level++) {
+            if (!(m_levels & (1u << level)))
+                continue;
+            const auto it = m_cells.find(Key { level, cell(position, m_cellSize * float(1 << level)) });
+            if (it == m_cells.end())
+                continue;
+            for (const uint32_t index : it->second) {
+                const Record &record = m_records[index];
+                const Vector offset = position - record.position;
+                // records that lie in front of the point see a different part of the scene
+                if (offset.dot(normal + record.normal) < -0.1f * record.radius)
+                    continue;
+                const float error = offset.length() / record.radius +
+                                    safe_sqrt(1 - normal.dot(record.normal));
+                if (!(error < m_error))
+                    continue;
+                // the weight falls off to zero at the threshold, which avoids discontinuities between records
+                const float weight = 1 / std::max(error, 1e-4f) - 1 / m_error;
+                const Vector rotation = record.normal.cross(normal);
+                for (int channel = 0; channel < Color::NumComponents; channel++) {
+                    const float extrapolated = record.irradiance[channel] +
+                                               rotation.dot(record.rotational[channel]) +
+                                               offset.dot(record.translational[channel]);
+                    irradiance[channel] += weight * std::max(extrapolated, 0.f);
+                }
+                weightSum += weight;
+            }
+        }
+        if (!(weightSum > 0))
+            return std::nullopt;
+        return irradiance / weightSum;
+    }
+
+    std::string toString() const {
+        if (!m_enabled)
+            return "IrradianceCache[ off ]";
+        return tfm::format("IrradianceCache[ depth = %d, error = %f, strata = %dx%d ]",
+                           m_depth,
+                           m_error,
+                           m_thetaStrata,
+                           m_phiStrata);
+    }
+};
+
+}
@@ -1,13 +1,33 @@
+#include "lightwave/camera.hpp"
 #include "lightwave/instance.hpp"
 #include "lightwave/integrator.hpp"
+#include "lightwave/iterators.hpp"
 #include "lightwave/light.hpp"
+#include "lightwave/parallel.hpp"
 #include "lightwave/registry.hpp"
 
+#include "irradiancecache.hpp"
+#include "resampling.hpp"
+#include "roulette.hpp"
+#include "shadowqueue.hpp"
+#include "splitting.hpp"
+
 namespace lightwave {
 
 class MISPathTracerIntegrator final : public SamplingIntegrator {
     const cref<Scene> m_scene;
     const int m_depth;
+    const RussianRoulette m_roulette;
+    const LightResampler m_resampler;
+    const LightSplitting m_splitting;
+    IrradianceCache m_cache;
+    /**
+     * @brief Whether shadow rays are queued and traced once all samples of a tile have been shaded, instead of right
+     * after they have been created (see @ref ShadowQueue ).
+     */
+    const bool m_shadowBatching;
+    /// @brief Whether batched shadow rays are sorted by direction and origin before they are traced.
+    const bool m_shadowSorting;
 
     float balanceHeuristic(float f, float g) { return f / (f + g); }
     float powerHeuristic(float f, float g) {
@@ -17,65 +37,116 @@ class MISPathTracerIntegrator final : public SamplingIntegrator {
             return 1;
     }
 
-public:
-    MISPathTracerIntegrator(const Properties &properties)
-        : SamplingIntegrator(properties),
-          m_scene(properties.getChild<Scene>("scene")),
-          m_depth(properties.get<int>("depth", 2)) {}
+    /// @brief Whether the irradiance cache can stand in for the light leaving a surface.
+    bool isCacheable(const Intersection &its) const {
+        return its.instance->bsdf() && its.instance->bsdf()->isDiffuse() && its.frame.normal.dot(its.wo) > 0;
+    }
+
+    /**
+     * @brief Fills the irradiance cache by following one path per pixel up to the vertex at which the cache is used,
+     * and creating a record there unless the existing ones already cover it. Pixels are visited on successively finer
+     * lattices, so that records spread evenly before the gaps between them are filled.
+     */
+    void populateCache() {
+        m_cache.reset(m_scene->getBoundingBox());
 
-    Color Li(const Ray &ray, Sampler &rng) override {
-        Intersection its;
+        const Vector2i resolution = m_scene->camera()->resolution();
+        const auto cloneSampler = [&] { return m_sampler->clone(); };
+        // like training passes, the pre-pass continues the sequences of the pixels after the samples of the image
+        const int sampleOffset = options.sampleOffset + std::max(options.sampleCount, m_sampler->samplesPerPixel());
+        Timer timer;
+        for (int stride = 16, pass = 0; stride >= 1; stride /= 2, pass++) {
+            for_each_parallel(BlockSpiral(resolution, Vector2i(64)), cloneSampler, [&](auto block, ref<Sampler> &rng) {
+                for (auto pixel : block) {
+                    if (pixel.x() % stride || pixel.y() % stride)
+                        continue;
+                    rng->seed(pixel, sampleOffset + pass);
+                    Intersection its = m_scene->intersect(m_scene->camera()->sample(pixel, *rng).ray, *rng);
+                    for (int depth = 1; depth < m_cache.depth() && its && !its.instance->emission(); depth++) {
+                        const BsdfSample bs = its.sampleBsdf(*rng);
+                        if (bs.isInvalid())
+                            break;
+                        its = m_scene->intersect(Ray(its.position, bs.wi), *rng);
+                    }
+                    if (!its || its.instance->emission() || !isCacheable(its) ||
+                        m_cache.lookup(its.position, its.frame.normal))
+                        continue;
+                    m_cache.insert(m_cache.compute(its.position, its.frame, *rng, [&](const Ray &ray, float &distance) {
+                        const Intersection hit = m_scene->intersect(ray, *rng);
+                        distance = hit ? hit.t : Infinity;
+                        return hit ? radiance(hit, *rng, m_cache.depth() + 1, false) : Color(0);
+                    }));
+                }
+            });
+        }
+        logger(EInfo, "populated irradiance cache with %ld records (%.2fs)", m_cache.size(), timer.getElapsedTime());
+    }
+
+    /**
+     * @brief Returns the radiance leaving a surface towards @c its.wo .
+     * @param firstDepth The index of the vertex at the surface, counted from the camera (starting at 1).
+     * @param emitted Whether light emitted by the surface is included.
+     * @param shadows If given, the shadow rays of next event estimation are queued for slot @c slot instead of being
+     * traced, and the returned radiance lacks their contributions.
+     */
+    Color radiance(const Intersection &hit, Sampler &rng, int firstDepth, bool emitted, ShadowQueue *shadows = nullptr,
+                   uint32_t slot = 0) {
+        Intersection its = hit;
         Color bsdf_color;
         Color light_color;
         Color weight = Color::white();
-        LightSample ls;
-        DirectLightSample dls;
-        BsdfEval be;
         BsdfSample bs;
         BackgroundLightEval ble;
         float w;
 
-        its = m_scene->intersect(ray, rng);
-        if (not its)
-            return m_scene->evaluateBackground(ray.direction).value;
         if (its.instance->emission())
-            return its.evaluateEmission();
-
-        for (int depth = 1; depth < m_depth; depth++) {
-            if (not m_scene->hasLights())
-                goto cont;
-            ls = m_scene->sampleLight(rng);
-            dls = ls.light->sampleDirect(its.position, rng);
-            if (dls.isInvalid())
-                goto cont;
-            if (m_scene->intersect(
-                    Ray(its.position, dls.wi), dls.distance, rng))
-                goto cont;
-            be = its.evaluateBsdf(dls.wi);
-            if (be.isInvalid()) [[unlikely]]
-                goto cont;
-            w = ls.light->canBeIntersected()
-                    ? powerHeuristic(dls.pdf * ls.probability,
-                                     be.pdf * dls.cosTheta_o)
-                    : 1;
-            light_color += w * weight * be.value * dls.weight / ls.probability;
-        cont:
+            return emitted ? its.evaluateEmission() : Color::black();
+
+        for (int depth = firstDepth; depth < m_depth; depth++) {
+            std::optional<Color> irradiance;
+            // the cache leaves direct light to next event estimation, hence it needs light samples
+            if (depth == m_cache.depth() && m_cache.enabled() && m_splitting.count(depth) > 0 && isCacheable(its))
+                irradiance = m_cache.lookup(its.position, its.frame.normal);
+            m_splitting.sample(*m_scene, its, rng, depth, m_resampler, [&](const ResampledLightSample &rls) {
+                // the weights only need to sum to one with those of BSDF sampling, hence they can ignore resampling
+                const float w = rls.light->canBeIntersected() && !irradiance
+                                    ? powerHeuristic(rls.dls.pdf * rls.probability * m_splitting.count(depth),
+                                                     rls.be.pdf * rls.dls.cosTheta_o)
+                                    : 1;
+                const Ray shadowRay(its.position, rls.dls.wi);
+                if (shadows)
+                    shadows->push(slot, shadowRay, rls.dls.distance, rls.light, w * weight * rls.weight);
+                else if (not m_scene->intersect(shadowRay, rls.dls.distance, rng, rls.light))
+                    light_color += w * weight * rls.weight;
+            });
+            if (irradiance) {
+                // the cache holds the indirect light only, as direct light has been sampled above
+                bsdf_color = weight * its.evaluateAlbedo() * InvPi * *irradiance;
+                break;
+            }
             bs = its.sampleBsdf(rng);
             if (bs.isInvalid()) [[unlikely]]
                 break;
             weight *= bs.weight;
+            if (not m_roulette.survive(depth, weight, rng))
+                break;
             auto r = Ray(its.position, bs.wi);
             its = m_scene->intersect(r, rng);
             if (not its) {
                 ble = m_scene->evaluateBackground(r.direction);
-                w = powerHeuristic(bs.pdf * ble.sinTheta, ble.pdf);
+                // without a background, both pdfs are zero and the weight would be nan
+                if (ble.isInvalid())
+                    break;
+                w = powerHeuristic(
+                    bs.pdf * ble.sinTheta,
+                    m_splitting.selectionDensity(*m_scene, m_scene->background(), r.origin, depth) * ble.pdf);
                 bsdf_color = w * weight * ble.value;
                 break;
             } else if (its.instance->emission()) {
                 auto light = its.instance->light();
                 if (light) {
                     auto cosTheta_o = its.frame.normal.dot(its.wo);
-                    auto pl = m_scene->lightSelectionProbability(light) *
+                    auto pl = m_splitting.selectionDensity(*m_scene, light, r.origin, depth) *
                               its.pdf * sqr(its.t);
                     w = powerHeuristic(bs.pdf * cosTheta_o, pl);
                 } else {
@@ -88,15 +159,104 @@ public:
         return bsdf_color + light_color;
     }
 
+    /// @brief Returns the radiance arriving along a camera ray (see @ref radiance for the handling of shadow rays).
+    Color incident(const Ray &ray, Sampler &rng, ShadowQueue *shadows = nullptr, uint32_t slot = 0) {
+        const Intersection its = m_scene->intersect(ray, rng);
+        if (not its)
+            return m_scene->evaluateBackground(ray.direction).value;
+        return radiance(its, rng, 1, true, shadows, slot);
+    }
+
+protected:
+    int renderBlock(const Bounds2i &block, Sampler &sampler, int target, bool skipConverged) override {
+        if (!m_shadowBatching)
+            return SamplingIntegrator::renderBlock(block, sampler, target, skipConverged);
+
+        // the samples of a tile, whose radiance is completed once their shadow rays have been traced
+        struct PendingSample {
+            Point2i pixel;
+            Color cameraWeight;
+            Color radiance;
+        };
+        std::vector<PendingSample> samples;
+        ShadowQueue shadows;
+        int taken = 0;
+        for (auto tileIndex : Bounds2i(Vector2i(0), (block.diagonal() + Vector2i(AdaptiveTileSize - 1)) / AdaptiveTileSize)) {
+            const Point2i tileMin = block.min() + AdaptiveTileSize * Vector2i(tileIndex);
+            const Bounds2i tile = block.clip(Bounds2i(tileMin, tileMin + Vector2i(AdaptiveTileSize)));
+            if (skipConverged && hasConverged(tile))
+                continue;
+
+            samples.clear();
+            shadows.clear();
+            for (auto pixel : tile) {
+                for (int sample = m_film(pixel).count; sample < target; sample++) {
+                    sampler.seed(pixel, options.sampleOffset + sample);
+                    auto cameraSample = m_scene->camera()->sample(pixel, sampler);
+                    const uint32_t slot = uint32_t(samples.size());
+                    samples.push_back({
+                        .pixel = pixel,
+                        .cameraWeight = cameraSample.weight,
+                        .radiance = incident(cameraSample.ray, sampler, &shadows, slot),
+                    });
+                    recordAuxiliaryOutputs(pixel, cameraSample.ray, sampler);
+                }
+            }
+
+            shadows.trace(*m_scene, sampler, m_shadowSorting, [&](uint32_t slot, const Color &contribution) {
+                samples[slot].radiance += contribution;
+            });
+            // samples are added in the order they were taken, as the variance estimates depend on the order
+            for (const PendingSample &sample : samples)
+                m_film(sample.pixel).add(sample.cameraWeight * sample.radiance);
+            taken += int(samples.size());
+        }
+        m_film.develop(*m_image, block);
+        return taken;
+    }
+
+public:
+    MISPathTracerIntegrator(const Properties &properties)
+        : SamplingIntegrator(properties),
+          m_scene(properties.getChild<Scene>("scene")),
+          m_depth(properties.get<int>("depth", 2)),
+          m_roulette(properties),
+          m_resampler(properties),
+          m_splitting(properties),
+          m_cache(properties),
+          m_shadowBatching(properties.get<bool>("shadowBatching", false)),
+          m_shadowSorting(properties.get<bool>("shadowSorting", false)) {}
+
+    void execute() override {
+        // the cache is only looked up at vertices that still scatter light
+        if (m_cache.enabled() && m_cache.depth() < m_depth)
+            populateCache();
+        SamplingIntegrator::execute();
+    }
+
+    Color Li(const Ray &ray, Sampler &rng) override { return incident(ray, rng); }
+
     /// @brief An optional textual representation of this class, which can be useful for debugging.
     std::string toString() const override {
         return tfm::format(
             "MISPathTracerIntegrator[\n"
             "  depth = %d\n"
+            "  roulette = %s\n"
+            "  resampler = %s\n"
+            "  splitting = %s\n"
+            "  cache = %s\n"
+            "  shadowBatching = %s\n"
+            "  shadowSorting = %s\n"
             "  sampler = %s,\n"
             "  image = %s,\n"
             "]",
             m_depth,
+            m_roulette.toString(),
+            m_resampler.toString(),
+            m_splitting.toString(),
+            m_cache.toString(),
+            m_shadowBatching,
+            m_shadowSorting,
             indent(m_sampler),
             indent(m_image));
     }
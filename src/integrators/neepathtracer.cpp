@@ -3,25 +3,32 @@
 #include "lightwave/light.hpp"
 #include "lightwave/registry.hpp"
 
+#include "resampling.hpp"
+#include "roulette.hpp"
+#include "splitting.hpp"
+
 namespace lightwave {
 
 class NeePathTracerIntegrator final : public SamplingIntegrator {
     const cref<Scene> m_scene;
     const int m_depth;
+    const RussianRoulette m_roulette;
+    const LightResampler m_resampler;
+    const LightSplitting m_splitting;
 
 public:
     NeePathTracerIntegrator(const Properties &properties)
         : SamplingIntegrator(properties),
           m_scene(properties.getChild<Scene>("scene")),
-          m_depth(properties.get<int>("depth", 2)) {}
+          m_depth(properties.get<int>("depth", 2)),
+          m_roulette(properties),
+          m_resampler(properties),
+          m_splitting(properties) {}
 
     Color Li(const Ray &ray, Sampler &rng) override {
         Intersection its;
         Color light_color;
         Color weight = Color::white();
-        LightSample ls;
-        DirectLightSample dls;
-        BsdfEval be;
 
         its = m_scene->intersect(ray, rng);
         if (not its)
@@ -30,25 +37,16 @@ public:
             return its.evaluateEmission();
 
         for (int depth = 1; depth < m_depth; depth++) {
-            if (not m_scene->hasLights())
-                goto cont;
-            ls = m_scene->sampleLight(rng);
-            dls = ls.light->sampleDirect(its.position, rng);
-            // assert(dls.weight.r() <= 2.f);
-            if (dls.isInvalid()) [[unlikely]]
-                goto cont;
-            if (m_scene->intersect(
-                    Ray(its.position, dls.wi), dls.distance, rng))
-                goto cont;
-            be = its.evaluateBsdf(dls.wi);
-            if (be.isInvalid()) [[unlikely]]
-                goto cont;
-            light_color += weight * be.value * dls.weight / ls.probability;
-        cont:
+            m_splitting.sample(*m_scene, its, rng, depth, m_resampler, [&](const ResampledLightSample &rls) {
+                if (!m_scene->intersect(Ray(its.position, rls.dls.wi), rls.dls.distance, rng, rls.light))
+                    light_color += weight * rls.weight;
+            });
             auto bs = its.sampleBsdf(rng);
             if (bs.isInvalid()) [[unlikely]]
                 break;
             weight *= bs.weight;
+            if (not m_roulette.survive(depth, weight, rng))
+                break;
             its = m_scene->intersect(Ray(its.position, bs.wi), rng);
             if (not its || its.instance->emission())
                 break;
@@ -61,10 +59,16 @@ public:
         return tfm::format(
             "MISPathTracerIntegrator[\n"
             "  depth = %d\n"
+            "  roulette = %s\n"
+            "  resampler = %s\n"
+            "  splitting = %s\n"
             "  sampler = %s,\n"
             "  image = %s,\n"
             "]",
             m_depth,
+            m_roulette.toString(),
+            m_resampler.toString(),
+            m_splitting.toString(),
             indent(m_sampler),
             indent(m_image));
     }
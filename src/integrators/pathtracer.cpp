@@ -3,17 +3,21 @@
 #include "lightwave/light.hpp"
 #include "lightwave/registry.hpp"
 
+#include "roulette.hpp"
+
 namespace lightwave {
 
 class PathTracerIntegrator final : public SamplingIntegrator {
     const cref<Scene> m_scene;
     const int m_depth;
+    const RussianRoulette m_roulette;
 
 public:
     PathTracerIntegrator(const Properties &properties)
         : SamplingIntegrator(properties),
           m_scene(properties.getChild<Scene>("scene")),
-          m_depth(properties.get<int>("depth", 2)) {}
+          m_depth(properties.get<int>("depth", 2)),
+          m_roulette(properties) {}
 
     Color Li(const Ray &ray, Sampler &rng) override {
         Intersection its;
@@ -34,8 +38,8 @@ public:
         for (int depth = 1; depth < m_depth; depth++) {
             if (not m_scene->hasLights())
                 goto cont;
-            ls = m_scene->sampleLight(rng);
-            if (ls.light->canBeIntersected())
+            ls = m_scene->sampleLight(its.position, rng);
+            if (ls.isInvalid() || ls.light->canBeIntersected())
                 goto cont;
             dls = ls.light->sampleDirect(its.position, rng);
             if (dls.isInvalid()) [[unlikely]]
@@ -52,6 +56,8 @@ public:
             if (bs.isInvalid()) [[unlikely]]
                 break;
             weight *= bs.weight;
+            if (not m_roulette.survive(depth, weight, rng))
+                break;
             its = m_scene->intersect(Ray(its.position, bs.wi), rng);
             if (not its) {
                 bsdf_color = weight * m_scene->evaluateBackground(bs.wi).value;
@@ -69,10 +75,12 @@ public:
         return tfm::format(
             "MISPathTracerIntegrator[\n"
             "  depth = %d\n"
+            "  roulette = %s\n"
             "  sampler = %s,\n"
             "  image = %s,\n"
             "]",
             m_depth,
+            m_roulette.toString(),
             indent(m_sampler),
             indent(m_image));
     }
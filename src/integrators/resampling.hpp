@@ -0,0 +1,108 @@
+/**
+ * @brief Resampled importance sampling of direct lighting for the path tracing integrators.
+ * @file resampling.hpp
+ */
+
+#pragma once
+
+#include <lightwave/instance.hpp>
+#include <lightwave/light.hpp>
+#include <lightwave/properties.hpp>
+#include <lightwave/sampler.hpp>
+#include <lightwave/scene.hpp>
+
+namespace lightwave {
+
+/// @brief A light sample picked by @ref LightResampler::sample .
+struct ResampledLightSample {
+    /// @brief The light source that has been picked.
+    const Light *light;
+    /// @brief The probability of the light source being picked by @ref Scene::sampleLight .
+    float probability;
+    /// @brief The sample on the light source, as produced by @ref Light::sampleDirect .
+    DirectLightSample dls;
+    /// @brief The BSDF evaluated towards the light sample.
+    BsdfEval be;
+    /// @brief The contribution of the sample, assuming it is visible (i.e., BSDF times incident radiance divided by
+    /// the effective density of resampling).
+    Color weight;
+
+    /// @brief Tests whether the sample is invalid (i.e., no candidate could contribute).
+    bool isInvalid() const { return !light; }
+};
+
+/**
+ * @brief Picks light samples for next event estimation by resampled importance sampling (Talbot et al., "Importance
+ * Resampling for Global Illumination", 2005), which is the basis of ReSTIR (Bitterli et al., 2020).
+ *
+ * A number of candidates is drawn with @ref Scene::sampleLight and @ref Light::sampleDirect , and streamed through a
+ * weighted reservoir that keeps one of them with a probability proportional to the luminance of its unshadowed
+ * contribution (i.e., including the BSDF). Only the candidate that is kept needs a shadow ray, so taking more
+ * candidates trades cheap light and BSDF evaluations for a better distribution of shadow rays. As the resampling
+ * weights are ratios of the target function and the density of the candidates, they simply are the luminance of the
+ * one-sample estimates of each candidate, and no densities need to be known.
+ *
+ * With a single candidate, this is equivalent to sampling one light source directly.
+ */
+class LightResampler {
+    /// @brief The number of candidates per light sample.
+    int m_candidates;
+
+public:
+    LightResampler(const Properties &properties) {
+        m_candidates = std::max(properties.get<int>("lightCandidates", 1), 1);
+    }
+
+    /// @brief Whether more than one candidate is taken per light sample.
+    bool enabled() const { return m_candidates > 1; }
+
+    /**
+     * @brief Picks a light sample for a surface among a number of candidates.
+     * @param intersectable Whether light sources that can be hit by rays (e.g., area lights) are candidates. Rejected
+     * candidates still count towards the number of candidates, as they have been drawn.
+     */
+    ResampledLightSample sample(const Scene &scene, const Intersection &its, Sampler &rng,
+                                bool intersectable = true) const {
+        ResampledLightSample result { .light = nullptr };
+        if (!scene.hasLights())
+            return result;
+
+        float weightSum = 0;
+        float keptWeight = 0;
+        for (int candidate = 0; candidate < m_candidates; candidate++) {
+            const LightSample ls = scene.sampleLight(its.position, rng);
+            if (ls.isInvalid() || (!intersectable && ls.light->canBeIntersected()))
+                continue;
+            const DirectLightSample dls = ls.light->sampleDirect(its.position, rng);
+            if (dls.isInvalid()) [[unlikely]]
+                continue;
+            const BsdfEval be = its.evaluateBsdf(dls.wi);
+            if (be.isInvalid()) [[unlikely]]
+                continue;
+
+            const Color contribution = be.value * dls.weight / ls.probability;
+            const float weight = contribution.luminance();
+            if (!(weight > 0))
+                continue;
+            weightSum += weight;
+            // the first candidate with a positive weight is always kept, which needs no random number
+            if (weightSum == weight || rng.next() * weightSum < weight) {
+                result = {
+                    .light = ls.light,
+                    .probability = ls.probability,
+                    .dls = dls,
+                    .be = be,
+                    .weight = contribution,
+                };
+                keptWeight = weight;
+            }
+        }
+        if (!result.isInvalid())
+            result.weight *= weightSum / (m_candidates * keptWeight);
+        return result;
+    }
+
+    std::string toString() const { return tfm::format("LightResampler[ candidates = %d ]", m_candidates); }
+};
+
+}
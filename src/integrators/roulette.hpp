@@ -0,0 +1,54 @@
+/**
+ * @brief Russian roulette for the path tracing integrators.
+ * @file roulette.hpp
+ */
+
+#pragma once
+
+#include <lightwave/color.hpp>
+#include <lightwave/properties.hpp>
+#include <lightwave/sampler.hpp>
+
+namespace lightwave {
+
+/**
+ * @brief Terminates paths whose throughput has become small, and re-weights the surviving paths so that the estimate
+ * stays unbiased. Paths survive with a probability proportional to their throughput, which keeps the weights of
+ * surviving paths close to one instead of spending the same effort on paths that contribute almost nothing.
+ */
+class RussianRoulette {
+    /// @brief Whether paths may be terminated at all.
+    bool m_enabled;
+    /// @brief The number of bounces after which roulette starts.
+    int m_minDepth;
+    /// @brief The survival probability is capped to avoid arbitrarily long paths in closed, white scenes.
+    float m_maxSurvival;
+
+public:
+    RussianRoulette(const Properties &properties) {
+        m_enabled = properties.get<bool>("russianRoulette", true);
+        m_minDepth = properties.get<int>("rouletteDepth", 3);
+        m_maxSurvival = properties.get<float>("rouletteMaxSurvival", 0.95f);
+    }
+
+    /**
+     * @brief Decides whether a path continues after @c depth bounces, dividing its throughput by the survival
+     * probability if it does.
+     * @return Whether the path survives.
+     */
+    bool survive(int depth, Color &weight, Sampler &rng) const {
+        if (!m_enabled || depth < m_minDepth)
+            return true;
+        const float survival = std::min(weight.maxComponent(), m_maxSurvival);
+        if (!(rng.next() < survival))
+            return false;
+        weight /= survival;
+        return true;
+    }
+
+    std::string toString() const {
+        return m_enabled ? tfm::format("RussianRoulette[ depth = %d ]", m_minDepth) : "RussianRoulette[ off ]";
+    }
+};
+
+}
@@ -0,0 +1,322 @@
+#pragma once
+
+#include <lightwave/core.hpp>
+#include <lightwave/math.hpp>
+#include <lightwave/parallel.hpp>
+
+#include <ranges>
+#include <vector>
+
+namespace lightwave {
+
+/// @brief Maps a direction to the unit square by an area-preserving cylindrical projection (cosine of theta, phi).
+inline Point2 directionToCanonical(const Vector &direction) {
+    const float cosTheta = std::clamp(direction.z(), -1.f, 1.f);
+    float phi = std::atan2(direction.y(), direction.x());
+    if (phi < 0)
+        phi += 2 * Pi;
+    return Point2(std::min((cosTheta + 1) / 2, OneMinusEpsilon), std::min(phi * Inv2Pi, OneMinusEpsilon));
+}
+
+/// @brief The inverse of @ref directionToCanonical . As the projection preserves areas, densities differ by 4 pi.
+inline Vector canonicalToDirection(const Point2 &point) {
+    const float cosTheta = 2 * point.x() - 1;
+    const float sinTheta = safe_sqrt(1 - sqr(cosTheta));
+    const float phi = 2 * Pi * point.y();
+    return Vector(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+}
+
+/**
+ * @brief A quadtree over the unit square of directions (see @ref directionToCanonical ) that learns the distribution
+ * of incident radiance at a region of space, and samples directions proportionally to it.
+ *
+ * Samples are splatted into the leaf they fall into using atomic additions, so that all threads can record into the
+ * same tree without locking. The structure of the tree only changes between training iterations, when @ref build
+ * propagates the energy of the leaves to their ancestors and @ref refined subdivides where energy concentrates.
+ */
+class QuadTree {
+    struct Node {
+        /// @brief The energy of each of the four quadrants (x is the low bit of the quadrant index, y the high bit).
+        float sums[4] = { 0, 0, 0, 0 };
+        /// @brief The child nodes of each quadrant, where 0 denotes a leaf (the root is never a child).
+        uint32_t children[4] = { 0, 0, 0, 0 };
+
+        float total() const { return sums[0] + sums[1] + sums[2] + sums[3]; }
+    };
+
+    std::vector<Node> m_nodes;
+    /// @brief The energy of the entire tree (only valid after @ref build ).
+    float m_total = 0;
+    /// @brief The number of samples recorded since the last iteration.
+    int64_t m_count = 0;
+
+    /// @brief Returns the quadrant a point falls into, and remaps the point to the unit square of that quadrant.
+    static int descend(Point2 &point) {
+        int quadrant = 0;
+        for (int dim = 0; dim < 2; dim++) {
+            point[dim] *= 2;
+            if (point[dim] >= 1) {
+                point[dim] -= 1;
+                quadrant |= 1 << dim;
+            }
+        }
+        return quadrant;
+    }
+
+public:
+    QuadTree() : m_nodes(1) {}
+
+    float total() const { return m_total; }
+    int64_t count() const { return m_count; }
+    void setCount(int64_t count) { m_count = count; }
+
+    /// @brief Records an estimate of the incident radiance in a direction divided by the pdf it was sampled with.
+    void record(Point2 point, float value) {
+        if (!(value > 0) || !std::isfinite(value))
+            value = 0;
+        atomicAdd(m_count, 1);
+        if (value == 0)
+            return;
+
+        uint32_t index = 0;
+        while (true) {
+            Node &node = m_nodes[index];
+            const int quadrant = descend(point);
+            if (!node.children[quadrant]) {
+                atomicAdd(node.sums[quadrant], value);
+                return;
+            }
+            index = node.children[quadrant];
+        }
+    }
+
+    /// @brief Propagates the energy recorded in the leaves to all inner nodes.
+    void build() {
+        // children are always created after their parents, hence a reverse sweep visits them first
+        for (size_t index = m_nodes.size(); index-- > 0;) {
+            Node &node = m_nodes[index];
+            for (int quadrant = 0; quadrant < 4; quadrant++) {
+                if (node.children[quadrant])
+                    node.sums[quadrant] = m_nodes[node.children[quadrant]].total();
+            }
+        }
+        m_total = m_nodes.front().total();
+    }
+
+    /**
+     * @brief Returns an empty tree whose quadrants are subdivided wherever they hold more than a fraction of
+     * @c threshold of the energy of this (built) tree, and collapsed elsewhere.
+     */
+    QuadTree refined(float threshold, int maxDepth) const {
+        QuadTree result;
+        if (!(m_total > 0)) {
+            result.m_nodes = m_nodes;
+            for (auto &node : result.m_nodes)
+                std::fill(std::begin(node.sums), std::end(node.sums), 0.f);
+            return result;
+        }
+
+        struct Entry {
+            uint32_t index;
+            /// @brief The corresponding node of this tree, or -1 if this tree is coarser at this point.
+            int64_t original;
+            float sum;
+            int depth;
+        };
+        std::vector<Entry> stack = { { 0, 0, m_total, 1 } };
+        while (!stack.empty()) {
+            const Entry entry = stack.back();
+            stack.pop_back();
+            for (int quadrant = 0; quadrant < 4; quadrant++) {
+                // where this tree has no nodes, its energy is assumed to be spread uniformly
+                const float sum = entry.original >= 0 ? m_nodes[entry.original].sums[quadrant] : entry.sum / 4;
+                if (entry.depth >= maxDepth || !(sum > threshold * m_total))
+                    continue;
+
+                const int64_t original = entry.original >= 0 && m_nodes[entry.original].children[quadrant]
+                                             ? int64_t(m_nodes[entry.original].children[quadrant])
+                                             : -1;
+                const uint32_t child = uint32_t(result.m_nodes.size());
+                result.m_nodes.emplace_back();
+                result.m_nodes[entry.index].children[quadrant] = child;
+                stack.push_back({ child, original, sum, entry.depth + 1 });
+            }
+        }
+        return result;
+    }
+
+    /// @brief Samples a point of the unit square proportionally to the energy of the (built) tree.
+    Point2 sample(Point2 u, float &pdf) const {
+        pdf = 1;
+        if (!(m_total > 0))
+            return u;
+
+        Point2 origin(0, 0);
+        float size = 1;
+        uint32_t index = 0;
+        while (true) {
+            const Node &node = m_nodes[index];
+            const float total = node.total();
+            if (!(total > 0))
+                break;
+
+            // pick the column first and then the row within it, remapping the random numbers after each decision
+            const float left = (node.sums[0] + node.sums[2]) / total;
+            int quadrant = 0;
+            if (u.x() < left) {
+                u.x() = u.x() / left;
+            } else {
+                u.x() = (u.x() - left) / (1 - left);
+                quadrant = 1;
+            }
+            const float bottom = node.sums[quadrant] / (node.sums[quadrant] + node.sums[quadrant + 2]);
+            if (u.y() < bottom) {
+                u.y() = u.y() / bottom;
+            } else {
+                u.y() = (u.y() - bottom) / (1 - bottom);
+                quadrant += 2;
+            }
+            u = Point2(std::min(u.x(), OneMinusEpsilon), std::min(u.y(), OneMinusEpsilon));
+
+            pdf *= 4 * node.sums[quadrant] / total;
+            size /= 2;
+            origin += size * Vector2(float(quadrant & 1), float(quadrant >> 1));
+            if (!node.children[quadrant])
+                break;
+            index = node.children[quadrant];
+        }
+        return Point2(std::min(origin.x() + size * u.x(), OneMinusEpsilon),
+                      std::min(origin.y() + size * u.y(), OneMinusEpsilon));
+    }
+
+    /// @brief Returns the density of @ref sample with respect to the area of the unit square.
+    float pdf(Point2 point) const {
+        if (!(m_total > 0))
+            return 1;
+
+        float pdf = 1;
+        uint32_t index = 0;
+        while (true) {
+            const Node &node = m_nodes[index];
+            const float total = node.total();
+            if (!(total > 0))
+                return pdf;
+            const int quadrant = descend(point);
+            pdf *= 4 * node.sums[quadrant] / total;
+            if (!node.children[quadrant])
+                return pdf;
+            index = node.children[quadrant];
+        }
+    }
+
+    size_t nodeCount() const { return m_nodes.size(); }
+};
+
+/**
+ * @brief The spatio-directional tree of Müller et al. ("Practical Path Guiding for Efficient Light-Transport
+ * Simulation", 2017): a binary tree over space that alternates between the axes when splitting, whose leaves hold
+ * directional quadtrees.
+ *
+ * Each leaf holds two quadtrees: one that was learned in the previous training iteration and is sampled from, and one
+ * that the current iteration records into.
+ */
+class SDTree {
+    struct Node {
+        /// @brief The child nodes for the lower and upper half along the split axis.
+        uint32_t children[2];
+        /// @brief The index into m_leaves, for leaf nodes.
+        uint32_t leaf;
+        uint8_t axis;
+        bool isLeaf;
+    };
+
+public:
+    struct Leaf {
+        QuadTree sampling;
+        QuadTree building;
+    };
+
+private:
+    std::vector<Node> m_nodes;
+    std::vector<Leaf> m_leaves;
+    /// @brief The cube enclosing the scene, whose octants the tree subdivides.
+    Point m_origin;
+    float m_size;
+
+public:
+    SDTree() {}
+    SDTree(const Bounds &bounds) {
+        // a cube keeps the cells of alternating splits close to cubes as well
+        m_size = bounds.diagonal().maxComponent() * 1.01f;
+        m_origin = bounds.center() - Vector(m_size / 2);
+        m_nodes.push_back({ .children = { 0, 0 }, .leaf = 0, .axis = 0, .isLeaf = true });
+        m_leaves.emplace_back();
+    }
+
+    /// @brief Returns the leaf containing a given point (points outside the scene are clamped to its bounds).
+    Leaf &lookup(const Point &point) {
+        Vector p = (point - m_origin) / m_size;
+        for (int dim = 0; dim < 3; dim++)
+            p[dim] = std::clamp(p[dim], 0.f, OneMinusEpsilon);
+
+        uint32_t index = 0;
+        while (!m_nodes[index].isLeaf) {
+            const Node &node = m_nodes[index];
+            p[node.axis] *= 2;
+            int child = 0;
+            if (p[node.axis] >= 1) {
+                p[node.axis] -= 1;
+                child = 1;
+            }
+            index = node.children[child];
+        }
+        return m_leaves[m_nodes[index].leaf];
+    }
+
+    /**
+     * @brief Finishes a training iteration: splits leaves that received more than @c spatialThreshold samples, and
+     * turns what was recorded into the distributions sampled from during the next iteration.
+     */
+    void refine(int64_t spatialThreshold, float directionalThreshold, int maxDirectionalDepth) {
+        const auto leaves = [&] { return std::views::iota(size_t(0), m_leaves.size()); };
+        for_each_parallel(leaves(), [&](size_t leaf) { m_leaves[leaf].building.build(); });
+
+        // new nodes are appended, so that they are checked for further splits by the same loop
+        for (size_t index = 0; index < m_nodes.size(); index++) {
+            if (!m_nodes[index].isLeaf)
+                continue;
+            Leaf &leaf = m_leaves[m_nodes[index].leaf];
+            if (leaf.building.count() <= spatialThreshold)
+                continue;
+
+            // both halves start with the directional distribution of their parent, and half of its samples
+            leaf.building.setCount(leaf.building.count() / 2);
+            const uint32_t newLeaf = uint32_t(m_leaves.size());
+            m_leaves.push_back(m_leaves[m_nodes[index].leaf]);
+
+            const uint8_t axis = (m_nodes[index].axis + 1) % 3;
+            const uint32_t first = uint32_t(m_nodes.size());
+            m_nodes.push_back({ .children = { 0, 0 }, .leaf = m_nodes[index].leaf, .axis = axis, .isLeaf = true });
+            m_nodes.push_back({ .children = { 0, 0 }, .leaf = newLeaf, .axis = axis, .isLeaf = true });
+            m_nodes[index].children[0] = first;
+            m_nodes[index].children[1] = first + 1;
+            m_nodes[index].isLeaf = false;
+        }
+
+        for_each_parallel(leaves(), [&](size_t leaf) {
+            m_leaves[leaf].sampling = std::move(m_leaves[leaf].building);
+            m_leaves[leaf].building = m_leaves[leaf].sampling.refined(directionalThreshold, maxDirectionalDepth);
+        });
+    }
+
+    size_t leafCount() const { return m_leaves.size(); }
+    /// @brief Returns the total number of nodes of all directional trees that are sampled from.
+    size_t directionalNodeCount() const {
+        size_t count = 0;
+        for (const auto &leaf : m_leaves)
+            count += leaf.sampling.nodeCount();
+        return count;
+    }
+};
+
+}
@@ -0,0 +1,124 @@
+/**
+ * @brief Deferred, coherent tracing of shadow rays for the path tracing integrators.
+ * @file shadowqueue.hpp
+ */
+
+#pragma once
+
+#include <lightwave/color.hpp>
+#include <lightwave/math.hpp>
+#include <lightwave/sampler.hpp>
+#include <lightwave/scene.hpp>
+
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace lightwave {
+
+/// @brief Computes a sort key that groups rays by direction octant, and then by origin along a Morton curve.
+inline uint32_t rayKey(const Ray &ray, const Bounds &bounds) {
+    constexpr int BitsPerAxis = 9;
+    uint32_t key = 0;
+    for (int dim = 0; dim < 3; dim++) {
+        const float extent = bounds.max()[dim] - bounds.min()[dim];
+        const float relative = extent > 0 ? (ray.origin[dim] - bounds.min()[dim]) / extent : 0;
+        const uint32_t cell = uint32_t(clamp(relative, 0, 1) * ((1 << BitsPerAxis) - 1));
+        for (int bit = 0; bit < BitsPerAxis; bit++)
+            key |= ((cell >> bit) & 1) << (3 * bit + dim);
+        if (ray.direction[dim] < 0)
+            key |= 1u << (3 * BitsPerAxis + dim);
+    }
+    return key;
+}
+
+/// @brief Sorts a queue of items by a 32-bit key (using a least significant digit radix sort).
+template <typename Key>
+void sortByKey(std::vector<uint32_t> &queue, Key key) {
+    constexpr int DigitBits = 11;
+    constexpr uint32_t DigitMask = (1u << DigitBits) - 1;
+    if (queue.size() < 2)
+        return;
+
+    std::vector<uint64_t> keyed(queue.size()), scratch(queue.size());
+    for (size_t i = 0; i < queue.size(); i++)
+        keyed[i] = (uint64_t(key(queue[i])) << 32) | queue[i];
+
+    std::vector<uint32_t> offsets(DigitMask + 1);
+    for (int shift = 32; shift < 64; shift += DigitBits) {
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (const uint64_t item : keyed)
+            offsets[(item >> shift) & DigitMask]++;
+        if (offsets[(keyed.front() >> shift) & DigitMask] == keyed.size())
+            continue; // all items share this digit
+        uint32_t sum = 0;
+        for (uint32_t &offset : offsets)
+            sum += std::exchange(offset, sum);
+        for (const uint64_t item : keyed)
+            scratch[offsets[(item >> shift) & DigitMask]++] = item;
+        std::swap(keyed, scratch);
+    }
+
+    for (size_t i = 0; i < queue.size(); i++)
+        queue[i] = uint32_t(keyed[i]);
+}
+
+/**
+ * @brief Shadow rays awaiting their visibility test, along with the contribution they add if unoccluded.
+ *
+ * Instead of testing each shadow ray as soon as shading creates it, which alternates between material code and BVH
+ * traversal, integrators queue the shadow rays of many paths (e.g., all samples of a tile) and test them in one go.
+ * The queue is sorted by @ref rayKey first, so that consecutive rays traverse similar parts of the BVH. Each ray
+ * refers to a slot (e.g., the path or sample it belongs to) that receives its contribution.
+ */
+class ShadowQueue {
+    std::vector<uint32_t> m_slots;
+    std::vector<Ray> m_rays;
+    std::vector<float> m_distances;
+    /// @brief The light source each ray is traced towards, which lets the scene test its last occluder first.
+    std::vector<const Light *> m_lights;
+    std::vector<Color> m_contributions;
+    /// @brief The order in which rays are traced, kept to reuse its capacity.
+    std::vector<uint32_t> m_order;
+
+public:
+    size_t size() const { return m_slots.size(); }
+
+    /// @brief Removes all rays, but keeps the capacity of the queue.
+    void clear() {
+        m_slots.clear();
+        m_rays.clear();
+        m_distances.clear();
+        m_lights.clear();
+        m_contributions.clear();
+    }
+
+    void push(uint32_t slot, const Ray &ray, float distance, const Light *light, const Color &contribution) {
+        m_slots.push_back(slot);
+        m_rays.push_back(ray);
+        m_distances.push_back(distance);
+        m_lights.push_back(light);
+        m_contributions.push_back(contribution);
+    }
+
+    /**
+     * @brief Tests the visibility of all queued rays, and invokes @c visible with the slot and contribution of each
+     * unoccluded one. The queue is left unchanged.
+     * @param sort Whether to trace rays in the order of @ref rayKey instead of the order they were queued in.
+     */
+    template <typename F>
+    void trace(const Scene &scene, Sampler &rng, bool sort, F visible) {
+        m_order.resize(size());
+        std::iota(m_order.begin(), m_order.end(), 0);
+        if (sort) {
+            const Bounds bounds = scene.getBoundingBox();
+            sortByKey(m_order, [&](uint32_t ray) { return rayKey(m_rays[ray], bounds); });
+        }
+        for (const uint32_t ray : m_order) {
+            if (not scene.intersect(m_rays[ray], m_distances[ray], rng, m_lights[ray]))
+                visible(m_slots[ray], m_contributions[ray]);
+        }
+    }
+};
+
+}
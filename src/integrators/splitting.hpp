@@ -0,0 +1,111 @@
+/**
+ * @brief Control over the number of light samples taken per vertex by the path tracing integrators.
+ * @file splitting.hpp
+ */
+
+#pragma once
+
+#include <lightwave/instance.hpp>
+#include <lightwave/light.hpp>
+#include <lightwave/properties.hpp>
+#include <lightwave/sampler.hpp>
+#include <lightwave/scene.hpp>
+
+#include <sstream>
+#include <vector>
+
+#include "resampling.hpp"
+
+namespace lightwave {
+
+/**
+ * @brief Decides how many light samples next event estimation takes at each vertex of a path. Near the camera,
+ * shadow rays are coherent and cheap compared to tracing entire paths, so spending several light samples on each
+ * camera ray can reduce noise for less than the cost of more samples per pixel.
+ *
+ * The number of samples is given per vertex as a comma-separated list (e.g., "4,1" takes four samples at the first
+ * vertex and one at all later vertices, as the last entry repeats). Zero disables next event estimation at a vertex.
+ * Samples pick their light source through a @ref LightResampler , unless the scene has few enough light sources to be
+ * split: then every light source receives the given number of samples, which removes the noise of picking lights.
+ *
+ * For combining light samples with BSDF sampling by MIS, @ref selectionDensity returns the expected number of samples
+ * that pick a given light source at a vertex, which takes the place of the probability of picking it once.
+ */
+class LightSplitting {
+    /// @brief The number of light samples for each vertex, where the last entry applies to all later vertices.
+    std::vector<int> m_counts;
+    /// @brief The largest number of light sources in a scene for which every light source is sampled.
+    int m_splitLimit;
+
+public:
+    LightSplitting(const Properties &properties) {
+        std::stringstream list(properties.get<std::string>("lightSamples", "1"));
+        std::string entry;
+        while (std::getline(list, entry, ','))
+            m_counts.push_back(std::max(parse_string<int>(entry), 0));
+        if (m_counts.empty())
+            lightwave_throw("\"lightSamples\" needs at least one entry");
+        m_splitLimit = std::max(properties.get<int>("lightSplitting", 0), 0);
+    }
+
+    /// @brief The number of light samples (or, when splitting, samples per light source) at a vertex of a path.
+    int count(int depth) const { return m_counts[std::min(size_t(std::max(depth, 1)), m_counts.size()) - 1]; }
+
+    /// @brief Whether every light source of the scene is sampled.
+    bool splits(const Scene &scene) const { return int(scene.lights().size()) <= m_splitLimit; }
+
+    /// @brief Returns the expected number of light samples at a vertex of a path that pick a given light source.
+    float selectionDensity(const Scene &scene, const Light *light, const Point &origin, int depth) const {
+        const float probability = scene.lightSelectionProbability(light, origin);
+        return count(depth) * (splits(scene) && probability > 0 ? 1 : probability);
+    }
+
+    /**
+     * @brief Takes the light samples of a vertex and invokes @c f with each of them. Their weights are divided by the
+     * number of samples, so that the contributions of all samples can simply be summed up.
+     * @note The @ref ResampledLightSample::probability of samples is 1 when light sources are split.
+     */
+    template <typename F>
+    void sample(const Scene &scene, const Intersection &its, Sampler &rng, int depth, const LightResampler &resampler,
+                F f) const {
+        const int samples = count(depth);
+        if (samples == 0 || !scene.hasLights())
+            return;
+        if (!splits(scene)) {
+            for (int i = 0; i < samples; i++) {
+                ResampledLightSample rls = resampler.sample(scene, its, rng);
+                if (rls.isInvalid())
+                    continue;
+                rls.weight /= samples;
+                f(rls);
+            }
+            return;
+        }
+        for (const auto &light : scene.lights()) {
+            for (int i = 0; i < samples; i++) {
+                const DirectLightSample dls = light->sampleDirect(its.position, rng);
+                if (dls.isInvalid()) [[unlikely]]
+                    continue;
+                const BsdfEval be = its.evaluateBsdf(dls.wi);
+                if (be.isInvalid())
+                    continue;
+                f(ResampledLightSample {
+                    .light = light.get(),
+                    .probability = 1,
+                    .dls = dls,
+                    .be = be,
+                    .weight = be.value * dls.weight / samples,
+                });
+            }
+        }
+    }
+
+    std::string toString() const {
+        std::string counts;
+        for (const int count : m_counts)
+            counts += (counts.empty() ? "" : ",") + std::to_string(count);
+        return tfm::format("LightSplitting[ samples = %s, limit = %d ]", counts, m_splitLimit);
+    }
+};
+
+}
@@ -0,0 +1,339 @@
+#include "lightwave/camera.hpp"
+#include "lightwave/instance.hpp"
+#include "lightwave/integrator.hpp"
+#include "lightwave/iterators.hpp"
+#include "lightwave/light.hpp"
+#include "lightwave/parallel.hpp"
+#include "lightwave/registry.hpp"
+#include "lightwave/streaming.hpp"
+
+#include "hashgrid.hpp"
+
+namespace lightwave {
+
+/**
+ * @brief Stochastic progressive photon mapping (Hachisuka and Jensen, "Stochastic Progressive Photon Mapping", 2009),
+ * which converges for light that reaches the camera via specular-diffuse-specular paths (e.g., caustics seen through
+ * glass), which path tracing cannot sample.
+ *
+ * Each iteration first traces one camera path per pixel through specular (delta) surfaces until it finds a surface
+ * that scatters light diffusely, where it estimates direct lighting by next event estimation and leaves a visible
+ * point. A number of photons is then traced from the light sources, and each pixel gathers the photons that have
+ * landed within a radius around its visible point, looked up through a @ref HashGrid that is rebuilt every iteration.
+ * The radius of each pixel shrinks with every photon it gathers, so that the estimate is consistent. All buffers are
+ * allocated once and reused across iterations.
+ *
+ * Photons carry indirect light only (direct lighting is handled by next event estimation), and are emitted by light
+ * sources that support @ref Light::sampleEmission (area and point lights). Indirect light from light sources that are
+ * infinitely far away (environment maps, directional lights) is therefore missing.
+ */
+class SPPMIntegrator final : public SamplingIntegrator {
+    /// @brief The state of a pixel that persists across iterations.
+    struct Pixel {
+        /// @brief The sum of the direct lighting (and light reaching the camera through specular paths) of all
+        /// iterations.
+        Color direct;
+        /// @brief The radius within which photons are gathered.
+        float radius;
+        /// @brief The (fractional) number of photons that have contributed to the flux.
+        float photonCount = 0;
+        /// @brief The flux gathered so far, which is scaled whenever the radius shrinks.
+        Color flux;
+
+        /// @brief The surface camera paths have stopped at in the current iteration (if @ref valid ).
+        Intersection its;
+        /// @brief The throughput of the camera path up to the visible point.
+        Color beta;
+        bool valid = false;
+    };
+
+    /// @brief A photon that has landed on a surface.
+    struct Photon {
+        Point position;
+        /// @brief The direction the photon has arrived from.
+        Vector wi;
+        /// @brief The flux the photon carries, which is zero for empty slots of the photon buffer.
+        Color beta;
+    };
+
+    const cref<Scene> m_scene;
+    /// @brief The maximal number of segments of camera paths and photon paths each.
+    const int m_depth;
+    /// @brief The number of photons traced per iteration.
+    const int m_photonsPerIteration;
+    /// @brief The fraction of newly gathered photons that is kept in each iteration, controlling how fast radii shrink.
+    const float m_alpha;
+    /// @brief The initial radius of all pixels (zero picks a radius relative to the size of the scene).
+    float m_initialRadius;
+
+    /// @brief The light sources photons start at, and how often they are picked.
+    std::vector<const Light *> m_emitters;
+    AliasTable m_emitterSelection;
+
+    std::vector<Pixel> m_pixels;
+    /// @brief The photons of the current iteration, with a fixed number of slots per photon path.
+    std::vector<Photon> m_photons;
+    HashGrid m_grid;
+
+    /// @brief The number of photons each iteration traces per work item.
+    static constexpr int PhotonChunkSize = 1024;
+
+    Pixel &pixelAt(const Point2i &pixel) {
+        return m_pixels[size_t(pixel.y()) * m_scene->camera()->resolution().x() + pixel.x()];
+    }
+
+    /// @brief Estimates direct lighting at a surface by sampling a light source.
+    Color estimateDirect(const Intersection &its, Sampler &rng) const {
+        if (!m_scene->hasLights())
+            return Color(0);
+        const LightSample ls = m_scene->sampleLight(its.position, rng);
+        if (ls.isInvalid())
+            return Color(0);
+        const DirectLightSample dls = ls.light->sampleDirect(its.position, rng);
+        if (dls.isInvalid())
+            return Color(0);
+        if (m_scene->intersect(Ray(its.position, dls.wi), dls.distance, rng, ls.light))
+            return Color(0);
+        const BsdfEval be = its.evaluateBsdf(dls.wi);
+        if (be.isInvalid())
+            return Color(0);
+        return be.value * dls.weight / ls.probability;
+    }
+
+    /// @brief Traces the camera path of a pixel and leaves its visible point.
+    void traceCameraPath(Pixel &pixel, const Ray &cameraRay, const Color &weight, Sampler &rng) const {
+        pixel.valid = false;
+        Ray ray = cameraRay;
+        Color beta = weight;
+        for (int depth = 0; depth < m_depth; depth++) {
+            const Intersection its = m_scene->intersect(ray, rng);
+            // light that is hit directly or through specular surfaces cannot be found by next event estimation
+            if (!its) {
+                pixel.direct += beta * m_scene->evaluateBackground(ray.direction).value;
+                return;
+            }
+            if (its.instance->emission()) {
+                pixel.direct += beta * its.evaluateEmission();
+                return;
+            }
+
+            const BsdfSample bs = its.sampleBsdf(rng);
+            if (bs.isInvalid())
+                return;
+            if (bs.pdf != 0) {
+                pixel.direct += beta * estimateDirect(its, rng);
+                pixel.its = its;
+                pixel.beta = beta;
+                pixel.valid = true;
+                return;
+            }
+            beta *= bs.weight;
+            ray = Ray(its.position, bs.wi);
+        }
+    }
+
+    /// @brief Traces a photon path from a randomly picked light source, and stores it in the given slots.
+    void tracePhoton(Photon *slots, Sampler &rng) const {
+        for (int i = 0; i < m_depth - 1; i++)
+            slots[i].beta = Color(0);
+        if (m_emitters.empty())
+            return;
+
+        const Sample1D selection = m_emitterSelection.sample(rng.next());
+        const EmissionSample es = m_emitters[selection.index]->sampleEmission(rng);
+        if (es.isInvalid())
+            return;
+        Ray ray(es.surface.position, es.direction);
+        Color beta = es.weight / selection.pdf;
+        for (int depth = 0; depth < m_depth; depth++) {
+            const Intersection its = m_scene->intersect(ray, rng);
+            if (!its)
+                return;
+            // the first surface a photon hits receives direct lighting, which next event estimation takes care of
+            if (depth > 0 && its.instance->bsdf()) {
+                slots[depth - 1] = { .position = its.position, .wi = its.wo, .beta = beta };
+            }
+
+            const BsdfSample bs = its.sampleBsdf(rng);
+            if (bs.isInvalid())
+                return;
+            // photons carry importance-transported flux, which is not scaled at refractive interfaces
+            beta *= bs.weight * sqr(bs.eta);
+            ray = Ray(its.position, bs.wi);
+        }
+    }
+
+    /// @brief Gathers the photons around the visible point of a pixel, and shrinks its radius accordingly.
+    void gather(Pixel &pixel) const {
+        if (!pixel.valid)
+            return;
+        const Intersection &its = pixel.its;
+        const Bsdf *bsdf = its.instance->bsdf();
+        const Vector wo = its.frame.toLocal(its.wo);
+        const float radius2 = sqr(pixel.radius);
+        // all photons are evaluated for the same outgoing direction, hence share the texture lookups of the BSDF
+        BsdfClosure closure;
+        bsdf->prepare(its.uv, wo, closure);
+
+        Color flux;
+        int count = 0;
+        m_grid.query(its.position, pixel.radius, [&](uint32_t index) {
+            const Photon &photon = m_photons[index];
+            if ((photon.position - its.position).lengthSquared() > radius2)
+                return;
+            const Vector wi = its.frame.toLocal(photon.wi);
+            const float cosTheta = Frame::absCosTheta(wi);
+            if (cosTheta == 0)
+                return;
+            const BsdfEval be = bsdf->evaluate(closure, wo, wi);
+            if (be.isInvalid())
+                return;
+            // the density of photons already accounts for the foreshortening the BSDF value includes
+            flux += be.value / cosTheta * photon.beta;
+            count++;
+        });
+        if (count == 0)
+            return;
+
+        const float photonCount = pixel.photonCount + m_alpha * count;
+        const float radius = pixel.radius * std::sqrt(photonCount / (pixel.photonCount + count));
+        pixel.flux = (pixel.flux + pixel.beta * flux) * sqr(radius / pixel.radius);
+        pixel.photonCount = photonCount;
+        pixel.radius = radius;
+    }
+
+    /// @brief Writes the current estimate of all pixels after a number of iterations into the image.
+    void develop(int iterations) {
+        const Vector2i resolution = m_scene->camera()->resolution();
+        const float photons = float(iterations) * m_photonsPerIteration;
+        for (auto position : Bounds2i(Point2i(0), resolution)) {
+            const Pixel &pixel = pixelAt(position);
+            (*m_image)(position) =
+                pixel.direct / float(iterations) + pixel.flux / (photons * Pi * sqr(pixel.radius));
+        }
+    }
+
+public:
+    SPPMIntegrator(const Properties &properties)
+        : SamplingIntegrator(properties),
+          m_scene(properties.getChild<Scene>("scene")),
+          m_depth(properties.get<int>("depth", 2)),
+          m_photonsPerIteration(std::max(properties.get<int>("photons", 100000), 1)),
+          m_alpha(std::clamp(properties.get<float>("alpha", 2.f / 3), 0.f, 1.f)),
+          m_initialRadius(properties.get<float>("radius", 0)) {
+        std::vector<float> weights;
+        const Bounds bounds = m_scene->getBoundingBox();
+        for (const auto &light : m_scene->lights()) {
+            if (!light->supportsEmissionSampling())
+                continue;
+            m_emitters.push_back(light.get());
+            weights.push_back(light->power(bounds).luminance());
+        }
+        for (const float weight : weights) {
+            if (!std::isfinite(weight) || weight < 0) {
+                logger(EWarn, "could not estimate the power of all lights, falling back to uniform light selection");
+                std::fill(weights.begin(), weights.end(), 1.f);
+                break;
+            }
+        }
+        if (!m_emitters.empty())
+            m_emitterSelection = AliasTable(weights);
+        if (m_emitters.size() < m_scene->lights().size())
+            logger(EWarn, "sppm cannot trace photons from environment maps or directional lights, their indirect "
+                          "lighting will be missing");
+
+        if (m_initialRadius <= 0)
+            m_initialRadius = 0.01f * bounds.diagonal().length();
+    }
+
+    void execute() override {
+        if (!m_image) {
+            lightwave_throw("<integrator /> needs an <image /> child to render into!");
+        }
+        if (m_adaptive || m_checkpointInterval > 0 || options.resume || !options.partial.empty() ||
+            options.region || options.sampleOffset > 0)
+            lightwave_throw("the sppm integrator does not support adaptive sampling, checkpoints or distributed "
+                            "rendering, as every iteration depends on all pixels");
+
+        const Vector2i resolution = m_scene->camera()->resolution();
+        const int iterations = options.sampleCount > 0 ? options.sampleCount : m_sampler->samplesPerPixel();
+        m_image->initialize(resolution);
+        m_pixels.assign(size_t(resolution.x()) * resolution.y(), Pixel{ .radius = m_initialRadius });
+        m_photons.resize(size_t(m_photonsPerIteration) * std::max(m_depth - 1, 0));
+
+        const int photonChunks = (m_photonsPerIteration + PhotonChunkSize - 1) / PhotonChunkSize;
+        const auto cloneSampler = [&] { return m_sampler->clone(); };
+        Streaming stream { *m_image };
+        stream.startRegularUpdates();
+        ProgressReporter progress { iterations };
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            for_each_parallel(BlockSpiral(resolution, Vector2i(64)), cloneSampler, [&](auto block, ref<Sampler> &sampler) {
+                for (auto pixel : block) {
+                    sampler->seed(pixel, iteration);
+                    auto cameraSample = m_scene->camera()->sample(pixel, *sampler);
+                    traceCameraPath(pixelAt(pixel), cameraSample.ray, cameraSample.weight, *sampler);
+                }
+            });
+
+            for_each_parallel(std::views::iota(0, m_depth > 1 ? photonChunks : 0), cloneSampler, [&](int chunk, ref<Sampler> &sampler) {
+                const int end = std::min((chunk + 1) * PhotonChunkSize, m_photonsPerIteration);
+                for (int photon = chunk * PhotonChunkSize; photon < end; photon++) {
+                    sampler->seed(iteration * m_photonsPerIteration + photon);
+                    tracePhoton(&m_photons[size_t(photon) * (m_depth - 1)], *sampler);
+                }
+            });
+
+            // cells as large as the largest radius keep lookups within a few cells
+            float maxRadius = 0;
+            for (const Pixel &pixel : m_pixels) {
+                if (pixel.valid)
+                    maxRadius = std::max(maxRadius, pixel.radius);
+            }
+            if (maxRadius > 0) {
+                m_grid.build(m_photons.size(), maxRadius, [&](size_t index, Point &position) {
+                    position = m_photons[index].position;
+                    return m_photons[index].beta != Color(0);
+                });
+                for_each_parallel(std::views::iota(0, resolution.y()), [&](int y) {
+                    for (int x = 0; x < resolution.x(); x++)
+                        gather(pixelAt(Point2i(x, y)));
+                });
+            }
+
+            develop(iteration + 1);
+            progress += 1;
+        }
+        progress.finish();
+        stream.stopRegularUpdates();
+        stream.update();
+        m_image->save();
+    }
+
+    Color Li(const Ray &ray, Sampler &rng) override {
+        lightwave_throw("the sppm integrator renders all pixels at once and cannot estimate the radiance of single "
+                        "rays");
+    }
+
+    /// @brief An optional textual representation of this class, which can be useful for debugging.
+    std::string toString() const override {
+        return tfm::format(
+            "SPPMIntegrator[\n"
+            "  depth = %d\n"
+            "  photons = %d\n"
+            "  alpha = %f\n"
+            "  radius = %f\n"
+            "  sampler = %s,\n"
+            "  image = %s,\n"
+            "]",
+            m_depth,
+            m_photonsPerIteration,
+            m_alpha,
+            m_initialRadius,
+            indent(m_sampler),
+            indent(m_image));
+    }
+};
+
+}
+
+REGISTER_INTEGRATOR(SPPMIntegrator, "sppm")
@@ -0,0 +1,282 @@
+#include "lightwave/camera.hpp"
+#include "lightwave/instance.hpp"
+#include "lightwave/integrator.hpp"
+#include "lightwave/light.hpp"
+#include "lightwave/registry.hpp"
+
+#include "roulette.hpp"
+#include "shadowqueue.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace lightwave {
+
+/**
+ * @brief A path tracer with multiple importance sampling that processes large batches of paths in stages instead of
+ * tracing one path at a time: camera rays of a batch are generated at once, and then every bounce intersects all
+ * rays, shades all hit points (sampling lights and BSDFs), and finally tests the visibility of all shadow rays.
+ *
+ * Between stages, the queues of paths are sorted: rays by direction octant and origin (along a Morton curve), which
+ * makes consecutive rays traverse similar parts of the BVH, and hit points by their BSDF, so that shading runs the
+ * same material code for many paths in a row. All per-path state is stored as structure of arrays.
+ *
+ * Every path owns a sampler that is seeded exactly like the one of a regular sampling integrator and is queried in the
+ * same order as in the "mispathtracer", hence both integrators compute identical estimates.
+ */
+class WavefrontPathTracerIntegrator final : public SamplingIntegrator {
+    const int m_depth;
+    const RussianRoulette m_roulette;
+    /// @brief The maximum number of paths that are in flight at once (per thread).
+    const int m_batchSize;
+    /// @brief Whether to sort rays and hit points between stages.
+    const bool m_sort;
+
+    /// @brief The state of a batch of paths, indexed by path.
+    struct Paths {
+        std::vector<Sampler *> samplers;
+        std::vector<Ray> rays;
+        std::vector<Intersection> hits;
+        std::vector<Color> weights;
+        /// @brief The pdf of the BSDF sample that generated the current ray, for weighting emitter hits.
+        std::vector<float> bsdfPdfs;
+        /// @brief The radiance found through light sampling.
+        std::vector<Color> lightColors;
+        /// @brief The radiance found through BSDF sampling (i.e., by hitting emitters or the background).
+        std::vector<Color> bsdfColors;
+
+        void resize(size_t count) {
+            samplers.resize(count);
+            rays.resize(count);
+            hits.resize(count);
+            weights.resize(count);
+            bsdfPdfs.resize(count);
+            lightColors.resize(count);
+            bsdfColors.resize(count);
+        }
+
+        /// @brief Starts a new path with a given (camera) ray.
+        void start(uint32_t path, const Ray &ray) {
+            rays[path] = ray;
+            weights[path] = Color::white();
+            lightColors[path] = Color::black();
+            bsdfColors[path] = Color::black();
+        }
+
+        /// @brief Returns the radiance carried by a finished path.
+        Color radiance(uint32_t path) const { return bsdfColors[path] + lightColors[path]; }
+    };
+
+    float powerHeuristic(float f, float g) const {
+        if (std::isfinite(sqr(f))) [[likely]]
+            return sqr(f) / (sqr(f) + sqr(g));
+        else
+            return 1;
+    }
+
+    /// @brief Finds the closest hit of the current ray of all paths in the queue.
+    void intersect(Paths &paths, std::vector<uint32_t> &queue, const Bounds &bounds) const {
+        if (m_sort)
+            sortByKey(queue, [&](uint32_t path) { return rayKey(paths.rays[path], bounds); });
+        for (const uint32_t path : queue)
+            paths.hits[path] = m_scene->intersect(paths.rays[path], *paths.samplers[path]);
+    }
+
+    /**
+     * @brief Traces the first @c count paths of a batch, whose camera rays have been set up with
+     * @ref Paths::start , until all of them have terminated.
+     */
+    void trace(Paths &paths, size_t count) const {
+        const Bounds bounds = m_scene->getBoundingBox();
+        std::vector<uint32_t> active(count), next;
+        std::iota(active.begin(), active.end(), 0);
+        next.reserve(count);
+        ShadowQueue shadows;
+
+        // camera rays directly see emitters without any weighting
+        intersect(paths, active, bounds);
+        for (const uint32_t path : active) {
+            const Intersection &its = paths.hits[path];
+            if (not its)
+                paths.bsdfColors[path] = m_scene->evaluateBackground(paths.rays[path].direction).value;
+            else if (its.instance->emission())
+                paths.bsdfColors[path] = its.evaluateEmission();
+            else
+                next.push_back(path);
+        }
+        std::swap(active, next);
+
+        for (int depth = 1; depth < m_depth && !active.empty(); depth++) {
+            // shading: sample lights (deferring the visibility test) and continue paths by sampling BSDFs
+            if (m_sort)
+                sortByKey(active, [&](uint32_t path) {
+                    return uint32_t(reinterpret_cast<uintptr_t>(paths.hits[path].instance->bsdf()) >> 4);
+                });
+            next.clear();
+            shadows.clear();
+            for (const uint32_t path : active) {
+                Sampler &rng = *paths.samplers[path];
+                const Intersection &its = paths.hits[path];
+                Color &weight = paths.weights[path];
+
+                if (m_scene->hasLights()) {
+                    const LightSample ls = m_scene->sampleLight(its.position, rng);
+                    const DirectLightSample dls =
+                        ls.isInvalid() ? DirectLightSample::invalid() : ls.light->sampleDirect(its.position, rng);
+                    if (not dls.isInvalid()) {
+                        const BsdfEval be = its.evaluateBsdf(dls.wi);
+                        if (not be.isInvalid()) {
+                            const float w = ls.light->canBeIntersected()
+                                                ? powerHeuristic(dls.pdf * ls.probability, be.pdf * dls.cosTheta_o)
+                                                : 1;
+                            shadows.push(path, Ray(its.position, dls.wi), dls.distance, ls.light,
+                                         w * weight * be.value * dls.weight / ls.probability);
+                        }
+                    }
+                }
+
+                const BsdfSample bs = its.sampleBsdf(rng);
+                if (bs.isInvalid()) [[unlikely]]
+                    continue;
+                weight *= bs.weight;
+                if (not m_roulette.survive(depth, weight, rng))
+                    continue;
+                paths.rays[path] = Ray(its.position, bs.wi);
+                paths.bsdfPdfs[path] = bs.pdf;
+                next.push_back(path);
+            }
+
+            shadows.trace(*m_scene, *paths.samplers[0], m_sort, [&](uint32_t path, const Color &contribution) {
+                paths.lightColors[path] += contribution;
+            });
+
+            // extension: find the next vertices, and terminate paths that hit emitters or escape
+            std::swap(active, next);
+            intersect(paths, active, bounds);
+            next.clear();
+            for (const uint32_t path : active) {
+                const Intersection &its = paths.hits[path];
+                const Color &weight = paths.weights[path];
+                const float bsdfPdf = paths.bsdfPdfs[path];
+                if (not its) {
+                    const BackgroundLightEval ble = m_scene->evaluateBackground(paths.rays[path].direction);
+                    if (not ble.isInvalid()) {
+                        const float pl =
+                            m_scene->lightSelectionProbability(m_scene->background(), paths.rays[path].origin);
+                        const float w = powerHeuristic(bsdfPdf * ble.sinTheta, pl * ble.pdf);
+                        paths.bsdfColors[path] = w * weight * ble.value;
+                    }
+                } else if (its.instance->emission()) {
+                    float w = 1;
+                    if (const Light *light = its.instance->light()) {
+                        const float cosTheta_o = its.frame.normal.dot(its.wo);
+                        const float pl = m_scene->lightSelectionProbability(light, paths.rays[path].origin) *
+                                         its.pdf * sqr(its.t);
+                        w = powerHeuristic(bsdfPdf * cosTheta_o, pl);
+                    }
+                    paths.bsdfColors[path] = w * weight * its.evaluateEmission();
+                } else {
+                    next.push_back(path);
+                }
+            }
+            std::swap(active, next);
+        }
+    }
+
+protected:
+    int renderBlock(const Bounds2i &block, Sampler &sampler, int target, bool skipConverged) override {
+        // collect all samples in the order in which the regular sampling integrator takes them
+        struct Job {
+            Point2i pixel;
+            int sample;
+        };
+        std::vector<Job> jobs;
+        for (auto tileIndex :
+             Bounds2i(Vector2i(0), (block.diagonal() + Vector2i(AdaptiveTileSize - 1)) / AdaptiveTileSize)) {
+            const Point2i tileMin = block.min() + AdaptiveTileSize * Vector2i(tileIndex);
+            const Bounds2i tile = block.clip(Bounds2i(tileMin, tileMin + Vector2i(AdaptiveTileSize)));
+            if (skipConverged && hasConverged(tile))
+                continue;
+            for (auto pixel : tile) {
+                for (int sample = m_film(pixel).count; sample < target; sample++)
+                    jobs.push_back({ pixel, sample });
+            }
+        }
+
+        const size_t batchSize = std::min(jobs.size(), size_t(m_batchSize));
+        std::vector<ref<Sampler>> samplers(batchSize);
+        Paths paths;
+        paths.resize(batchSize);
+        for (size_t i = 0; i < batchSize; i++) {
+            samplers[i] = sampler.clone();
+            paths.samplers[i] = samplers[i].get();
+        }
+
+        std::vector<Color> cameraWeights(batchSize);
+        std::vector<Ray> cameraRays(hasAuxiliaryOutputs() ? batchSize : 0);
+        for (size_t begin = 0; begin < jobs.size(); begin += batchSize) {
+            const size_t count = std::min(batchSize, jobs.size() - begin);
+            for (size_t i = 0; i < count; i++) {
+                const Job &job = jobs[begin + i];
+                paths.samplers[i]->seed(job.pixel, options.sampleOffset + job.sample);
+                const CameraSample cameraSample = m_scene->camera()->sample(job.pixel, *paths.samplers[i]);
+                paths.start(uint32_t(i), cameraSample.ray);
+                cameraWeights[i] = cameraSample.weight;
+                if (hasAuxiliaryOutputs())
+                    cameraRays[i] = cameraSample.ray;
+            }
+
+            trace(paths, count);
+
+            for (size_t i = 0; i < count; i++) {
+                m_film(jobs[begin + i].pixel).add(cameraWeights[i] * paths.radiance(uint32_t(i)));
+                if (hasAuxiliaryOutputs())
+                    recordAuxiliaryOutputs(jobs[begin + i].pixel, cameraRays[i], *paths.samplers[i]);
+            }
+        }
+
+        m_film.develop(*m_image, block);
+        return int(jobs.size());
+    }
+
+public:
+    WavefrontPathTracerIntegrator(const Properties &properties)
+        : SamplingIntegrator(properties),
+          m_depth(properties.get<int>("depth", 2)),
+          m_roulette(properties),
+          m_batchSize(std::max(properties.get<int>("batchSize", 1 << 12), 1)),
+          m_sort(properties.get<bool>("sort", true)) {}
+
+    /// @brief Traces a single path as a batch of one, which is only used when paths are not started by the camera.
+    Color Li(const Ray &ray, Sampler &rng) override {
+        Paths paths;
+        paths.resize(1);
+        paths.samplers[0] = &rng;
+        paths.start(0, ray);
+        trace(paths, 1);
+        return paths.radiance(0);
+    }
+
+    /// @brief An optional textual representation of this class, which can be useful for debugging.
+    std::string toString() const override {
+        return tfm::format(
+            "WavefrontPathTracerIntegrator[\n"
+            "  depth = %d\n"
+            "  roulette = %s\n"
+            "  batchSize = %d\n"
+            "  sort = %s\n"
+            "  sampler = %s,\n"
+            "  image = %s,\n"
+            "]",
+            m_depth,
+            m_roulette.toString(),
+            m_batchSize,
+            m_sort,
+            indent(m_sampler),
+            indent(m_image));
+    }
+};
+
+}
+
+REGISTER_INTEGRATOR(WavefrontPathTracerIntegrator, "wavefront")
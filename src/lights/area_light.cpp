@@ -2,14 +2,19 @@
 #include "lightwave/light.hpp"
 #include "lightwave/properties.hpp"
 #include "lightwave/registry.hpp"
+#include "lightwave/sampler.hpp"
+#include "lightwave/warp.hpp"
 
 namespace lightwave {
 class AreaLight final : public Light {
     const ref<Instance> m_instance;
+    /// @brief The surface area of the instance in world coordinates.
+    const float m_area;
 
 public:
     AreaLight(const Properties &properties)
-        : m_instance(properties.getChild<Instance>()) {
+        : m_instance(properties.getChild<Instance>()),
+          m_area(m_instance->area(nullptr)) {
         m_instance->setLight(this);
     }
 
@@ -44,6 +49,58 @@ public:
 
     bool canBeIntersected() const override { return true; }
 
+    bool supportsEmissionSampling() const override { return true; }
+
+    EmissionSample sampleEmission(Sampler &rng) const override {
+        const auto sa = m_instance->sampleSurface(rng);
+        if (sa.isInvalid()) [[unlikely]]
+            return EmissionSample::invalid();
+
+        const auto wo = squareToCosineHemisphere(rng.next2D());
+        const auto emission = m_instance->emission()->evaluate(sa.uv, wo);
+        if (emission.isInvalid()) [[unlikely]]
+            return EmissionSample::invalid();
+
+        // the cosine cancels with the density of the direction
+        return {
+            .surface = sa,
+            .direction = sa.frame.toWorld(wo),
+            .weight = emission.value * Pi / sa.pdf,
+            .pdfDirection = cosineHemispherePdf(wo),
+        };
+    }
+
+    Color evaluateEmission(const SurfaceEvent &surface,
+                           const Vector &direction) const override {
+        return m_instance->emission()
+            ->evaluate(surface.uv, surface.frame.toLocal(direction))
+            .value;
+    }
+
+    EmissionPdf pdfEmission(const SurfaceEvent &surface,
+                            const Vector &direction) const override {
+        // points are sampled uniformly by area (the actual density of
+        // ellipsoids slightly differs, but the estimates stay unbiased as long
+        // as all strategies agree on it)
+        return {
+            .position = 1 / m_area,
+            .direction = cosineHemispherePdf(surface.frame.toLocal(direction)),
+        };
+    }
+
+    Color power(const Bounds &sceneBounds) const override {
+        return m_instance->emission()->exitance() * m_area;
+    }
+
+    std::optional<LightBounds> bounds() const override {
+        return LightBounds{
+            .bounds = m_instance->getBoundingBox(),
+            .normals = m_instance->normalBounds(),
+            .cosThetaE = 0,
+            .twoSided = false,
+        };
+    }
+
     std::string toString() const override {
         return tfm::format(
             "AreaLight[\n"
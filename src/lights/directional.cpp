@@ -26,6 +26,11 @@ public:
 
     bool canBeIntersected() const override { return false; }
 
+    Color power(const Bounds &sceneBounds) const override {
+        // the irradiance falls onto the disk the scene occupies when seen from the light
+        return Pi * sqr(sceneBounds.diagonal().length() / 2) * m_intensity;
+    }
+
     std::string toString() const override {
         return tfm::format(
             "PointLight[\n"
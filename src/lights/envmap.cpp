@@ -9,23 +9,23 @@
 
 namespace lightwave {
 
-inline Vector sphericalDirection(float sinTheta, float cosTheta, float phi) {
+static inline Vector sphericalDirection(float sinTheta, float cosTheta, float phi) {
     return Vector(std::clamp(sinTheta, -1.f, 1.f) * std::cos(phi),
                   std::clamp(cosTheta, -1.f, 1.f),
                   std::clamp(sinTheta, -1.f, 1.f) * std::sin(phi));
 }
 
-inline float sphericalTheta(const Vector &w) { return safe_acos(w.y()); }
+static inline float sphericalTheta(const Vector &w) { return safe_acos(w.y()); }
 
-inline float sphericalPhi(const Vector &w) { return std::atan2(w.z(), w.x()); }
+static inline float sphericalPhi(const Vector &w) { return std::atan2(w.z(), w.x()); }
 
-inline Point2 to_uv(const Vector &w) {
+static inline Point2 to_uv(const Vector &w) {
     float u = 0.5 - sphericalPhi(w) * Inv2Pi;
     float v = sphericalTheta(w) * InvPi;
     return Point2(u, v);
 }
 
-inline Vector to_cartisian(Point2 &uv) {
+static inline Vector to_cartisian(Point2 &uv) {
     float theta = uv.y() * Pi;
     float sinTheta = std::sin(theta);
     float cosTheta = std::cos(theta);
@@ -41,9 +41,42 @@ class EnvironmentMap final : public BackgroundLight {
     const cref<Transform> m_transform;
 
     const bool m_improved_sampling;
-    ScalarImage m_scalar;
     Distribution2D m_distr;
 
+    /**
+     * @brief Computes the map the directions are importance sampled from, with at most @c maxWidth columns (or the
+     * resolution of the texture, if @c maxWidth is zero).
+     * The map is cached in the temporary directory under the hash of the texture, so that repeated renders with the
+     * same environment map can skip its computation.
+     */
+    ScalarImage importanceMap(int maxWidth, bool cache) const {
+        std::filesystem::path cachePath;
+        const uint64_t hash = m_texture->hash();
+        if (cache && hash) {
+            cachePath = std::filesystem::temp_directory_path() / "lightwave" /
+                        tfm::format("envmap_%016x_%d.bin", hash, maxWidth);
+            ScalarImage map;
+            if (map.load(cachePath)) {
+                logger(EInfo, "loaded envmap distribution from %s", cachePath);
+                return map;
+            }
+        }
+
+        Timer timer;
+        ScalarImage map = m_texture->scalar();
+        if (maxWidth > 0 && map.resolution().x() > maxWidth)
+            map = map.downsample((map.resolution().x() + maxWidth - 1) / maxWidth);
+        logger(EInfo, "computed %dx%d envmap distribution in %.1f ms", map.resolution().x(), map.resolution().y(),
+               timer.getElapsedTime() * 1000);
+
+        if (!cachePath.empty()) {
+            std::error_code error;
+            std::filesystem::create_directories(cachePath.parent_path(), error);
+            map.save(cachePath);
+        }
+        return map;
+    }
+
 public:
     EnvironmentMap(const Properties &properties)
         : m_texture(properties.getChild<Texture>()),
@@ -51,8 +84,8 @@ public:
           m_improved_sampling(
               properties.get<bool>("improved_sampling", false)) {
         if (m_improved_sampling) {
-            m_scalar = m_texture->scalar();
-            m_distr = Distribution2D(m_scalar);
+            m_distr = Distribution2D(importanceMap(properties.get<int>("distribution_width", 0),
+                                                   properties.get<bool>("cache", true)));
         }
     }
 
@@ -117,6 +150,23 @@ public:
         }
     }
 
+    Color power(const Bounds &sceneBounds) const override {
+        // integrates the radiance over the sphere of directions on a grid in latitude-longitude parameterization,
+        // where each cell subtends a solid angle proportional to the sine of its latitude
+        constexpr int Width = 256, Height = 128;
+        Color radiance;
+        for (int y = 0; y < Height; y++) {
+            const float v = (y + 0.5f) / Height;
+            Color row;
+            for (int x = 0; x < Width; x++)
+                row += m_texture->evaluate(Point2((x + 0.5f) / Width, v));
+            radiance += std::sin(v * Pi) * row;
+        }
+        radiance *= 2 * Pi * Pi / (Width * Height);
+        // the radiance arriving from all directions falls onto the disk the scene occupies
+        return Pi * sqr(sceneBounds.diagonal().length() / 2) * radiance;
+    }
+
     std::string toString() const override {
         return tfm::format(
             "EnvironmentMap[\n"
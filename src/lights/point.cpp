@@ -1,6 +1,8 @@
 #include "lightwave/light.hpp"
 #include "lightwave/properties.hpp"
 #include "lightwave/registry.hpp"
+#include "lightwave/sampler.hpp"
+#include "lightwave/warp.hpp"
 
 namespace lightwave {
 
@@ -28,6 +30,43 @@ public:
 
     bool canBeIntersected() const override { return false; }
 
+    bool supportsEmissionSampling() const override { return true; }
+
+    EmissionSample sampleEmission(Sampler &rng) const override {
+        EmissionSample sample;
+        sample.surface.position = m_position;
+        sample.surface.pdf = 1;
+        sample.direction = squareToUniformSphere(rng.next2D());
+        sample.weight = 4 * Pi * m_intensity;
+        sample.pdfDirection = Inv4Pi;
+        return sample;
+    }
+
+    Color evaluateEmission(const SurfaceEvent &surface,
+                           const Vector &direction) const override {
+        return m_intensity;
+    }
+
+    EmissionPdf pdfEmission(const SurfaceEvent &surface,
+                            const Vector &direction) const override {
+        return { .position = 1, .direction = Inv4Pi };
+    }
+
+    Color power(const Bounds &sceneBounds) const override {
+        return 4 * Pi * m_intensity;
+    }
+
+    std::optional<LightBounds> bounds() const override {
+        Bounds bounds = Bounds::empty();
+        bounds.extend(m_position);
+        return LightBounds{
+            .bounds = bounds,
+            .normals = DirectionCone::all(),
+            .cosThetaE = 0,
+            .twoSided = false,
+        };
+    }
+
     std::string toString() const override {
         return tfm::format(
             "PointLight[\n"
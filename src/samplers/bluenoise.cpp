@@ -0,0 +1,107 @@
+#include "lightwave/registry.hpp"
+#include "lightwave/sampler.hpp"
+
+#include "scramble.h"
+#include "sobol.h"
+
+namespace lightwave {
+
+/**
+ * @brief Generates low-discrepancy samples whose errors are distributed as blue noise in screen space, i.e., the errors
+ * of neighboring pixels cancel out instead of forming clumps, which looks better at low sample counts and is easier to
+ * denoise.
+ *
+ * Rather than giving each pixel its own sequence, all pixels of a tile draw consecutive chunks of a single
+ * Owen-scrambled Sobol sequence (padded in groups of four dimensions as in the "sobol" sampler). Pixels are ranked
+ * along a randomly shuffled Morton curve (Ahmed and Wonka, "Screen-Space Blue-Noise Diffusion of Monte Carlo Sampling
+ * Error via Hierarchical Ordering of Pixels", 2020), so that every aligned block of 2^k x 2^k pixels receives an
+ * aligned block of sample indices. As such blocks of a Sobol sequence are well stratified, the samples of neighboring
+ * pixels complement each other in all dimensions, similar to the ranking keys of Heitz et al. ("A Low-Discrepancy
+ * Sampler that Distributes Monte Carlo Errors as a Blue Noise in Screen Space", 2019), but without any precomputed
+ * tables.
+ */
+class BlueNoise final : public Sampler {
+    /// @brief The base-2 logarithm of the edge length in pixels of the tiles that share a sequence.
+    static constexpr int TileBits = 8;
+
+    uint32_t m_seed;
+    /// @brief The number of index bits reserved for the samples of a pixel (enough to hold the sample count).
+    int m_sampleBits;
+
+    /// @brief The seed of the tile of the current pixel.
+    uint32_t m_tileSeed;
+    /// @brief The index of the current sample in the sequence of its tile.
+    uint32_t m_index;
+    /// @brief The index of the next group of dimensions.
+    int m_group;
+
+    /// @brief Interleaves the bits of an integer with zeros, as needed for Morton codes.
+    static uint32_t spreadBits(uint32_t x) {
+        x &= 0xffff;
+        x = (x | (x << 8)) & 0x00ff00ffu;
+        x = (x | (x << 4)) & 0x0f0f0f0fu;
+        x = (x | (x << 2)) & 0x33333333u;
+        x = (x | (x << 1)) & 0x55555555u;
+        return x;
+    }
+
+public:
+    BlueNoise(const Properties &properties) : Sampler(properties) {
+        m_seed = hash32(uint32_t(properties.get<int>("seed", 1337)));
+        m_sampleBits = 0;
+        while ((1 << m_sampleBits) < m_samplesPerPixel)
+            m_sampleBits++;
+        seed(0);
+    }
+
+    void start(int sampleIndex) override {
+        start(Point2i(0), sampleIndex);
+    }
+
+    void start(const Point2i &pixel, int sampleIndex) override {
+        constexpr int MortonBits = 2 * TileBits;
+        constexpr uint32_t Mask = (1u << TileBits) - 1;
+
+        m_tileSeed = hashCombine(hashCombine(m_seed, uint32_t(pixel.x() >> TileBits)), uint32_t(pixel.y() >> TileBits));
+        // owen scrambling the morton code randomly reorders the quadrants on every level of the hierarchy
+        const uint32_t morton = spreadBits(uint32_t(pixel.x()) & Mask) | (spreadBits(uint32_t(pixel.y()) & Mask) << 1);
+        const uint32_t rank = owenScramble(morton << (32 - MortonBits), m_tileSeed) >> (32 - MortonBits);
+
+        // samples beyond the sample count continue in the next block of the sequence that is large enough for the
+        // entire tile, so that they do not overlap with the samples of other pixels
+        const uint32_t sample = uint32_t(sampleIndex);
+        const uint32_t round = sample >> m_sampleBits;
+        m_index = uint32_t(uint64_t(round) << (m_sampleBits + MortonBits)) | (rank << m_sampleBits) |
+                  (sample & ((1u << m_sampleBits) - 1));
+        m_group = 0;
+    }
+
+    void generate(float *values) override {
+        // each batch forms one group of dimensions, with its own shuffled sample index and scrambles
+        static_assert(BatchSize == SobolDimensions);
+        // owen scrambling the index maps aligned blocks of indices to aligned blocks, which preserves the
+        // stratification between neighboring pixels while decorrelating the groups of dimensions
+        const uint32_t groupSeed = hashCombine(m_tileSeed, uint32_t(m_group++));
+        const uint32_t groupIndex = owenScramble(m_index, groupSeed);
+        for (int component = 0; component < SobolDimensions; component++) {
+            const uint32_t value = owenScramble(sobol(groupIndex, component), hashCombine(groupSeed, component + 1));
+            values[component] = std::min(value * 0x1p-32f, OneMinusEpsilon);
+        }
+    }
+
+    ref<Sampler> clone() const override {
+        return std::make_shared<BlueNoise>(*this);
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "BlueNoise[\n"
+            "  count = %d\n"
+            "]",
+            m_samplesPerPixel);
+    }
+};
+
+}
+
+REGISTER_SAMPLER(BlueNoise, "bluenoise")
@@ -3,50 +3,207 @@
 
 #include "pcg32.h"
 #include "primes.h"
+#include "scramble.h"
+
+#include <utility>
 
 namespace lightwave {
 
+/// @brief The number of dimensions taken from the Halton sequence, after which independent numbers are returned.
+static constexpr int MaxDimensions = 256;
+/// @brief The number of dimensions whose radical inverse is specialized for a constant base (turning divisions
+/// into multiplications).
+static constexpr int SpecializedDimensions = 64;
+
+static constexpr uint32_t Primes[] = { PRIMES };
+
+/// @brief The number of pixels along each axis after which the per-pixel enumeration repeats, chosen as powers of
+/// the respective base.
+static constexpr uint64_t BaseScales[2] = { 128, 243 };
+static constexpr int BaseExponents[2] = { 7, 5 };
+/// @brief The distance between consecutive Halton indices that fall into the same pixel.
+static constexpr uint64_t SampleStride = BaseScales[0] * BaseScales[1];
+
+/// @brief Computes the inverse of @c a modulo @c n using the extended Euclidean algorithm.
+static constexpr uint64_t multiplicativeInverse(int64_t a, int64_t n) {
+    int64_t t = 0, newT = 1, r = n, newR = a % n;
+    while (newR) {
+        const int64_t quotient = r / newR;
+        std::tie(t, newT) = std::make_pair(newT, t - quotient * newT);
+        std::tie(r, newR) = std::make_pair(newR, r - quotient * newR);
+    }
+    return uint64_t(t < 0 ? t + n : t);
+}
+
+static constexpr uint64_t MultiplicativeInverses[2] = {
+    multiplicativeInverse(BaseScales[1], BaseScales[0]),
+    multiplicativeInverse(BaseScales[0], BaseScales[1]),
+};
+
+/// @brief The radical inverse in base 2 amounts to reversing the bits of the index.
+static float radicalInverse2(uint64_t index) {
+    return std::min(float(reverseBits64(index) * 0x1p-64), OneMinusEpsilon);
+}
+
+template <uint32_t Base>
+static float radicalInverse(uint64_t index) {
+    if constexpr (Base == 2)
+        return radicalInverse2(index);
+
+    constexpr float invBase = 1.f / Base;
+    uint64_t reversedDigits = 0;
+    float invBaseM = 1;
+    while (index) {
+        const uint64_t next = index / Base;
+        reversedDigits = reversedDigits * Base + (index - next * Base);
+        invBaseM *= invBase;
+        index = next;
+    }
+    return std::min(reversedDigits * invBaseM, OneMinusEpsilon);
+}
+
+/// @brief Computes the radical inverse of an index with permuted digits, including the (infinitely many) leading
+/// zero digits of the index, which are mapped to a geometric series of the permuted zero digit.
+template <uint32_t Base>
+static float scrambledRadicalInverse(const uint16_t *permutation, uint64_t index) {
+    constexpr float invBase = 1.f / Base;
+    uint64_t reversedDigits = 0;
+    float invBaseM = 1;
+    while (index) {
+        const uint64_t next = index / Base;
+        reversedDigits = reversedDigits * Base + permutation[index - next * Base];
+        invBaseM *= invBase;
+        index = next;
+    }
+    return std::min(invBaseM * (reversedDigits + invBase * permutation[0] / (1 - invBase)), OneMinusEpsilon);
+}
+
+/// @brief Like @ref scrambledRadicalInverse , for bases that are only known at runtime.
+static float scrambledRadicalInverse(uint32_t base, const uint16_t *permutation, uint64_t index) {
+    const float invBase = 1.f / base;
+    uint64_t reversedDigits = 0;
+    float invBaseM = 1;
+    while (index) {
+        const uint64_t next = index / base;
+        reversedDigits = reversedDigits * base + permutation[index - next * base];
+        invBaseM *= invBase;
+        index = next;
+    }
+    return std::min(invBaseM * (reversedDigits + invBase * permutation[0] / (1 - invBase)), OneMinusEpsilon);
+}
+
+/// @brief Maps the digits of a pixel coordinate back to the Halton index whose radical inverse produces them.
+template <uint32_t Base>
+static uint64_t inverseRadicalInverse(uint64_t inverse, int digits) {
+    uint64_t index = 0;
+    for (int i = 0; i < digits; i++) {
+        const uint64_t digit = inverse % Base;
+        inverse /= Base;
+        index = index * Base + digit;
+    }
+    return index;
+}
+
+using ScrambledRadicalInverse = float (*)(const uint16_t *, uint64_t);
+
+template <size_t... Dimensions>
+static constexpr auto specializedRadicalInverses(std::index_sequence<Dimensions...>) {
+    return std::array<ScrambledRadicalInverse, sizeof...(Dimensions)> {
+        &scrambledRadicalInverse<Primes[Dimensions]>...
+    };
+}
+
+static constexpr auto SpecializedRadicalInverses =
+    specializedRadicalInverses(std::make_index_sequence<SpecializedDimensions>());
+
+/**
+ * @brief Generates samples from the Halton sequence, whose dimensions are radical inverses of the sample index in
+ * successive prime bases.
+ *
+ * The first two dimensions are used to enumerate the samples of each pixel (as in pbrt): the Halton indices whose
+ * base-2 and base-3 radical inverses fall into a given pixel are consecutive multiples of a fixed stride, so that the
+ * samples within each pixel are well stratified. All further dimensions are scrambled with random digit permutations
+ * (one per base), which are precomputed and shared between all clones of a sampler.
+ */
 class Halton final : public Sampler {
-    uint64_t m_seed;
-    int m_sample_index;
-
-    static constexpr size_t m_prime_table_size = 1024;
-    std::array<uint32_t, m_prime_table_size> m_primes = {PRIMES};
-
-    inline float radical_inverse(uint32_t dimension, uint32_t sample_index) {
-        uint32_t limit = ~0u / dimension - dimension;
-        float invBase = 1.f / dimension, invBaseM = 1.f;
-        uint32_t reversedDigits = 0;
-        while (sample_index && reversedDigits < limit) {
-            uint32_t next = sample_index / dimension;
-            uint32_t digit = sample_index - next * dimension;
-            reversedDigits = reversedDigits * dimension + digit;
-            invBaseM *= invBase;
-            sample_index = next;
+    /// @brief The digit permutations of all dimensions, stored consecutively.
+    struct Permutations {
+        std::vector<uint16_t> digits;
+        std::array<uint32_t, MaxDimensions> offsets;
+
+        Permutations(uint64_t seed) {
+            pcg32 rng(seed);
+            for (int dimension = 0; dimension < MaxDimensions; dimension++) {
+                offsets[dimension] = uint32_t(digits.size());
+                const size_t begin = digits.size();
+                for (uint32_t digit = 0; digit < Primes[dimension]; digit++)
+                    digits.push_back(uint16_t(digit));
+                rng.shuffle(digits.begin() + begin, digits.end());
+            }
         }
-        return std::min(reversedDigits * invBaseM, 9.999999e-1f);
-    }
+
+        const uint16_t *operator[](int dimension) const { return &digits[offsets[dimension]]; }
+    };
+
+    uint64_t m_seed;
+    std::shared_ptr<const Permutations> m_permutations;
+
+    /// @brief The Halton index of the current sample.
+    uint64_t m_index;
+    /// @brief The pixel of the current sample modulo the base scales, or (-1,-1) if samples are not tied to pixels.
+    Point2i m_pixel;
+    int m_dimension;
+    /// @brief Generates the dimensions beyond @ref MaxDimensions .
+    pcg32 m_fallback;
 
 public:
-    Halton(const Properties &properties) : Sampler(properties) { m_seed = 0; }
+    Halton(const Properties &properties) : Sampler(properties) {
+        m_seed = properties.get<int>("seed", 1337);
+        m_permutations = std::make_shared<Permutations>(m_seed);
+        seed(0);
+    }
 
-    void seed(int sampleIndex) override {
-        m_seed = 0;
-        m_sample_index = sampleIndex;
+    void start(int sampleIndex) override {
+        m_index = uint64_t(sampleIndex);
+        m_pixel = Point2i(-1);
+        m_dimension = 0;
     }
 
-    void seed(const Point2i &pixel, int sampleIndex) override {
-        const uint64_t a = (uint64_t(pixel.x()) << 32) ^ pixel.y();
-        pcg32 pcg(1337, a);
-        seed(pcg.nextUInt() ^ sampleIndex);
+    void start(const Point2i &pixel, int sampleIndex) override {
+        m_pixel = Point2i(int(pixel.x() % BaseScales[0]), int(pixel.y() % BaseScales[1]));
+        const uint64_t offsetX = inverseRadicalInverse<2>(m_pixel.x(), BaseExponents[0]) *
+            (SampleStride / BaseScales[0]) * MultiplicativeInverses[0];
+        const uint64_t offsetY = inverseRadicalInverse<3>(m_pixel.y(), BaseExponents[1]) *
+            (SampleStride / BaseScales[1]) * MultiplicativeInverses[1];
+        m_index = (offsetX + offsetY) % SampleStride + uint64_t(sampleIndex) * SampleStride;
+        m_dimension = 0;
     }
 
-    float next() override {
-        m_seed = m_seed % m_prime_table_size;
-        return radical_inverse(m_primes[m_seed++], m_sample_index);
+    /// @brief Generates the next dimension of the current sample.
+    float nextDimension() {
+        const int dimension = m_dimension++;
+        if (dimension < 2) {
+            // the first two dimensions locate the sample within its pixel, hence they must not be scrambled
+            const float value = dimension == 0 ? radicalInverse<2>(m_index) : radicalInverse<3>(m_index);
+            if (m_pixel.x() < 0)
+                return value;
+            return clamp(value * BaseScales[dimension] - m_pixel[dimension], 0, OneMinusEpsilon);
+        }
+
+        if (dimension < SpecializedDimensions)
+            return SpecializedRadicalInverses[dimension]((*m_permutations)[dimension], m_index);
+        if (dimension < MaxDimensions)
+            return scrambledRadicalInverse(Primes[dimension], (*m_permutations)[dimension], m_index);
+
+        if (dimension == MaxDimensions)
+            m_fallback.seed(m_seed, m_index);
+        return m_fallback.nextFloat();
     }
 
-    Point2 next2D() override { return {next(), next()}; }
+    void generate(float *values) override {
+        for (int i = 0; i < BatchSize; i++)
+            values[i] = nextDimension();
+    }
 
     ref<Sampler> clone() const override {
         return std::make_shared<Halton>(*this);
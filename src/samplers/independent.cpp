@@ -22,15 +22,18 @@ public:
         m_seed = properties.get<int>("seed", 1337);
     }
 
-    void seed(int sampleIndex) override { m_pcg.seed(m_seed, sampleIndex); }
+    void start(int sampleIndex) override { m_pcg.seed(m_seed, sampleIndex); }
 
-    void seed(const Point2i &pixel, int sampleIndex) override {
+    void start(const Point2i &pixel, int sampleIndex) override {
         const uint64_t a = (uint64_t(pixel.x()) << 32) ^ pixel.y();
         m_pcg.seed(m_seed, a);
         m_pcg.seed(m_pcg.nextUInt(), sampleIndex);
     }
 
-    float next() override { return m_pcg.nextFloat(); }
+    void generate(float *values) override {
+        for (int i = 0; i < BatchSize; i++)
+            values[i] = m_pcg.nextFloat();
+    }
 
     ref<Sampler> clone() const override {
         return std::make_shared<Independent>(*this);
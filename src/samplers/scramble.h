@@ -0,0 +1,61 @@
+/**
+ * @file scramble.h
+ * @brief Bit manipulation and hashing helpers shared by the low-discrepancy
+ * samplers.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace lightwave {
+
+/// @brief Reverses the order of the bits of a 32-bit integer.
+inline uint32_t reverseBits32(uint32_t x) {
+    x = (x << 16) | (x >> 16);
+    x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+    x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+    x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+    x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+    return x;
+}
+
+/// @brief Reverses the order of the bits of a 64-bit integer.
+inline uint64_t reverseBits64(uint64_t x) {
+    return (uint64_t(reverseBits32(uint32_t(x))) << 32) |
+           reverseBits32(uint32_t(x >> 32));
+}
+
+/// @brief Mixes the bits of an integer (the finalizer of MurmurHash3).
+inline uint32_t hash32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+    return x;
+}
+
+/// @brief Combines a hash with another value.
+inline uint32_t hashCombine(uint32_t seed, uint32_t value) {
+    return seed ^ (hash32(value) + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+}
+
+/**
+ * @brief Applies a random Owen scramble to the bits of @c x, i.e., flips each
+ * bit depending on a hash of all more significant bits. Uses the hash-based
+ * construction of Burley ("Practical Hash-based Owen Scrambling", 2020) with
+ * the improved constants of Vegdahl.
+ */
+inline uint32_t owenScramble(uint32_t x, uint32_t seed) {
+    x = reverseBits32(x);
+    // Laine-Karras style permutation, which only propagates bits upwards
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return reverseBits32(x);
+}
+
+} // namespace lightwave
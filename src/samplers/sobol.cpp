@@ -0,0 +1,72 @@
+#include "lightwave/registry.hpp"
+#include "lightwave/sampler.hpp"
+
+#include "scramble.h"
+#include "sobol.h"
+
+namespace lightwave {
+
+/**
+ * @brief Generates samples from an Owen-scrambled Sobol sequence.
+ *
+ * Following Burley ("Practical Hash-based Owen Scrambling", 2020), dimensions are drawn in groups of four from the
+ * first four Sobol dimensions, which have excellent two- and four-dimensional projections. Each group shuffles the
+ * sample indices with its own Owen scramble (which keeps the first 2^k samples a permutation of the first 2^k points)
+ * and scrambles the resulting values independently, which decorrelates the groups. All scrambles are seeded from a hash
+ * of the pixel, so that neighboring pixels do not share their error patterns.
+ */
+class Sobol final : public Sampler {
+    uint32_t m_seed;
+
+    /// @brief The seed of the current pixel.
+    uint32_t m_pixelSeed;
+    /// @brief The index of the current sample within its pixel.
+    uint32_t m_index;
+    /// @brief The index of the next group of dimensions.
+    int m_group;
+
+public:
+    Sobol(const Properties &properties) : Sampler(properties) {
+        m_seed = hash32(uint32_t(properties.get<int>("seed", 1337)));
+        seed(0);
+    }
+
+    void start(int sampleIndex) override {
+        m_pixelSeed = m_seed;
+        m_index = uint32_t(sampleIndex);
+        m_group = 0;
+    }
+
+    void start(const Point2i &pixel, int sampleIndex) override {
+        m_pixelSeed = hashCombine(hashCombine(m_seed, uint32_t(pixel.x())), uint32_t(pixel.y()));
+        m_index = uint32_t(sampleIndex);
+        m_group = 0;
+    }
+
+    void generate(float *values) override {
+        // each batch forms one group of dimensions, with its own shuffled sample index and scrambles
+        static_assert(BatchSize == SobolDimensions);
+        const uint32_t groupSeed = hashCombine(m_pixelSeed, uint32_t(m_group++));
+        const uint32_t groupIndex = owenScramble(m_index, groupSeed);
+        for (int component = 0; component < SobolDimensions; component++) {
+            const uint32_t value = owenScramble(sobol(groupIndex, component), hashCombine(groupSeed, component + 1));
+            values[component] = std::min(value * 0x1p-32f, OneMinusEpsilon);
+        }
+    }
+
+    ref<Sampler> clone() const override {
+        return std::make_shared<Sobol>(*this);
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "Sobol[\n"
+            "  count = %d\n"
+            "]",
+            m_samplesPerPixel);
+    }
+};
+
+}
+
+REGISTER_SAMPLER(Sobol, "sobol")
@@ -0,0 +1,91 @@
+/**
+ * @file sobol.h
+ * @brief The generator matrices of the first Sobol dimensions, shared by the
+ * samplers built on top of the Sobol sequence.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace lightwave {
+
+/**
+ * @brief The parameters of the first Sobol dimensions following Joe and Kuo ("Constructing Sobol sequences with better
+ * two-dimensional projections", 2008): the degree of the primitive polynomial, its coefficients, and the initial
+ * direction numbers. The first dimension (the van der Corput sequence) is implied.
+ */
+struct SobolParameters {
+    int degree;
+    uint32_t coefficients;
+    uint32_t initial[3];
+};
+
+static constexpr SobolParameters SobolTable[] = {
+    { 1, 0, { 1 } },
+    { 2, 1, { 1, 3 } },
+    { 3, 1, { 1, 3, 1 } },
+};
+
+/// @brief The number of dimensions of the underlying Sobol sequence, beyond which it is padded.
+static constexpr int SobolDimensions = 4;
+
+/// @brief Computes the direction numbers (i.e., the columns of the generator matrix) of a Sobol dimension.
+static constexpr std::array<uint32_t, 32> sobolDirections(int dimension) {
+    std::array<uint32_t, 32> directions {};
+    if (dimension == 0) {
+        for (int bit = 0; bit < 32; bit++)
+            directions[bit] = 1u << (31 - bit);
+        return directions;
+    }
+
+    const SobolParameters &parameters = SobolTable[dimension - 1];
+    const int s = parameters.degree;
+    for (int bit = 0; bit < s; bit++)
+        directions[bit] = parameters.initial[bit] << (31 - bit);
+    for (int bit = s; bit < 32; bit++) {
+        directions[bit] = directions[bit - s] ^ (directions[bit - s] >> s);
+        for (int k = 1; k < s; k++) {
+            if ((parameters.coefficients >> (s - 1 - k)) & 1)
+                directions[bit] ^= directions[bit - k];
+        }
+    }
+    return directions;
+}
+
+/**
+ * @brief The generator matrices of the Sobol dimensions, tabulated per byte of the index: entry [d][k][b] holds the
+ * xor of the direction numbers of dimension d selected by byte k of the index having value b. As scrambled indices
+ * have all 32 bits populated, this replaces 32 conditional xors by four lookups.
+ */
+using SobolTables = std::array<std::array<std::array<uint32_t, 256>, 4>, SobolDimensions>;
+
+static constexpr SobolTables sobolTables() {
+    SobolTables tables {};
+    for (int dimension = 0; dimension < SobolDimensions; dimension++) {
+        const auto directions = sobolDirections(dimension);
+        for (int byte = 0; byte < 4; byte++) {
+            for (uint32_t value = 0; value < 256; value++) {
+                uint32_t result = 0;
+                for (int bit = 0; bit < 8; bit++) {
+                    if ((value >> bit) & 1)
+                        result ^= directions[8 * byte + bit];
+                }
+                tables[dimension][byte][value] = result;
+            }
+        }
+    }
+    return tables;
+}
+
+static constexpr SobolTables SobolMatrices = sobolTables();
+
+/// @brief Evaluates a Sobol dimension by xoring the direction numbers of all set bits of the index.
+inline uint32_t sobol(uint32_t index, int dimension) {
+    const auto &tables = SobolMatrices[dimension];
+    return tables[0][index & 0xff] ^ tables[1][(index >> 8) & 0xff] ^ tables[2][(index >> 16) & 0xff] ^
+           tables[3][index >> 24];
+}
+
+} // namespace lightwave
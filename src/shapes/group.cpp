@@ -49,6 +49,13 @@ public:
         return sample;
     }
 
+    float area(const Transform *transform) const override {
+        float result = 0;
+        for (auto &child : m_children)
+            result += child->area(transform);
+        return result;
+    }
+
     std::string toString() const override {
         std::stringstream oss;
         oss << "Group[" << std::endl;
@@ -65,6 +65,7 @@ protected:
             return false;
 
         its.t = t;
+        its.primitive = primitiveIndex;
         auto itp = Vertex::interpolate(Vector2(u, v), vert0, vert1, vert2);
         its.uv = itp.texcoords;
         if (m_smoothNormals) {
@@ -113,10 +114,31 @@ public:
         buildAccelerationStructure();
     }
 
+    bool intersectPrimitive(int primitive, const Ray &ray, Intersection &its,
+                            Sampler &rng) const override {
+        if (primitive < 0 || primitive >= numberOfPrimitives()) [[unlikely]]
+            return AccelerationStructure::intersect(ray, its, rng);
+        return intersect(primitive, ray, its, rng);
+    }
+
     AreaSample sampleArea(const Point &group, Sampler &rng) const override{
         // only implement this if you need triangle mesh area light sampling for your rendering competition
         NOT_IMPLEMENTED}
 
+    float area(const Transform *transform) const override {
+        float result = 0;
+        for (const auto &triangle : m_triangles) {
+            Point p[3];
+            for (int i = 0; i < 3; i++) {
+                p[i] = m_vertices[triangle[i]].position;
+                if (transform)
+                    p[i] = transform->apply(p[i]);
+            }
+            result += (p[1] - p[0]).cross(p[2] - p[0]).length() / 2;
+        }
+        return result;
+    }
+
     std::string toString() const override {
         return tfm::format(
             "Mesh[\n"
@@ -119,6 +119,26 @@ public:
         return sample;
     }
 
+    AreaSample sampleSurface(Sampler &rng) const override {
+        const Point2 u = rng.next2D();
+        AreaSample sample;
+        sample.position = Point(2 * u.x() - 1, 2 * u.y() - 1, 0);
+        sample.uv = u;
+        sample.frame.normal = Vector(0, 0, 1);
+        sample.frame.tangent = Vector(1, 0, 0);
+        sample.frame.bitangent = Vector(0, 1, 0);
+        sample.pdf = 1.f / 4;
+        return sample;
+    }
+
+    float area(const Transform *transform) const override {
+        if (!transform)
+            return 4;
+        return 4 * transform->apply(Vector(1, 0, 0)).cross(transform->apply(Vector(0, 1, 0))).length();
+    }
+
+    DirectionCone normalBounds() const override { return { Vector(0, 0, 1), 1 }; }
+
     std::string toString() const override { return "Rectangle[]"; }
 };
 
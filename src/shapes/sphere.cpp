@@ -2,26 +2,27 @@
 #include "lightwave/registry.hpp"
 #include "lightwave/sampler.hpp"
 #include "lightwave/shape.hpp"
+#include "lightwave/warp.hpp"
 
 namespace lightwave {
 
-inline Vector sphericalDirection(float sinTheta, float cosTheta, float phi) {
+static inline Vector sphericalDirection(float sinTheta, float cosTheta, float phi) {
     return Vector(std::clamp(sinTheta, -1.f, 1.f) * std::cos(phi),
                   std::clamp(sinTheta, -1.f, 1.f) * std::sin(phi),
                   std::clamp(cosTheta, -1.f, 1.f));
 }
 
-inline float sphericalTheta(const Vector &w) { return safe_acos(w.y()); }
+static inline float sphericalTheta(const Vector &w) { return safe_acos(w.y()); }
 
-inline float sphericalPhi(const Vector &w) { return std::atan2(w.x(), w.z()); }
+static inline float sphericalPhi(const Vector &w) { return std::atan2(w.x(), w.z()); }
 
-inline Point2 to_uv(const Vector &w) {
+static inline Point2 to_uv(const Vector &w) {
     float u = sphericalPhi(w) * Inv2Pi + 0.5;
     float v = sphericalTheta(w) * InvPi;
     return Point2(u, v);
 }
 
-inline Vector to_cartisian(Point2 &uv) {
+static inline Vector to_cartisian(Point2 &uv) {
     float theta = uv.y() * Pi;
     float sinTheta = std::sin(theta);
     float cosTheta = std::cos(theta);
@@ -118,6 +119,27 @@ public:
         return as;
     }
 
+    AreaSample sampleSurface(Sampler &rng) const override {
+        const Vector w = squareToUniformSphere(rng.next2D());
+        AreaSample as;
+        as.position = w;
+        as.frame = Frame(w);
+        as.uv = to_uv(w);
+        as.pdf = Inv4Pi;
+        return as;
+    }
+
+    float area(const Transform *transform) const override {
+        if (!transform)
+            return 4 * Pi;
+        // the surface area of an ellipsoid has no closed form; Thomsen's approximation is accurate to about one percent
+        constexpr float P = 1.6075f;
+        const float a = std::pow(transform->apply(Vector(1, 0, 0)).length(), P);
+        const float b = std::pow(transform->apply(Vector(0, 1, 0)).length(), P);
+        const float c = std::pow(transform->apply(Vector(0, 0, 1)).length(), P);
+        return 4 * Pi * std::pow((a * b + a * c + b * c) / 3, 1 / P);
+    }
+
     std::string toString() const override { return "Sphere[]"; }
 };
 }
@@ -0,0 +1,152 @@
+#include <lightwave.hpp>
+
+#include <random>
+
+namespace lightwave {
+
+/**
+ * @brief Measures how fast @ref Distribution2D samples a synthetic environment map of a given resolution, compared to
+ * the binary search over the CDFs it used before, and to an @ref AliasTable over all pixels.
+ *
+ * The image resembles an outdoor environment map: a noisy sky that gets brighter towards the horizon, with a tiny and
+ * very bright sun. All methods are fed the same precomputed random numbers, and the guide tables of
+ * @ref Distribution1D must reproduce the samples of the binary search exactly. The throughput is reported in million
+ * samples per second.
+ */
+class DistributionBenchmark : public Test {
+    /// @brief The resolution of the synthetic environment map.
+    Point2i m_resolution;
+    /// @brief The number of samples that are drawn with each method.
+    int m_samples;
+
+    /// @brief Samples a distribution by binary search over its CDF, as @ref Distribution1D did before.
+    static Sample1D sampleBinarySearch(const Distribution1D &distribution, float u) {
+        const auto cdf = distribution.cdf();
+        const size_t size = distribution.data().size();
+        const size_t offset = std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin() - 1;
+        float du = u - cdf[offset];
+        if (cdf[offset + 1] - cdf[offset] > 0)
+            du /= (cdf[offset + 1] - cdf[offset]);
+        const float pdf = distribution.sum() == 0 ? 1.f : distribution.data()[offset] / distribution.sum();
+        return {
+            .index = offset,
+            .u = (offset + du) / size,
+            .pdf = pdf,
+        };
+    }
+
+    ScalarImage generateImage() const {
+        std::mt19937 rng(1337);
+        std::uniform_real_distribution<float> noise(0.5f, 1.5f);
+        const Point2 sun(0.3f, 0.35f);
+        std::vector<float> data(size_t(m_resolution.x()) * m_resolution.y());
+        for (int y = 0; y < m_resolution.y(); y++) {
+            for (int x = 0; x < m_resolution.x(); x++) {
+                const Point2 uv((x + 0.5f) / m_resolution.x(), (y + 0.5f) / m_resolution.y());
+                float value = noise(rng) * (0.2f + uv.y());
+                if ((uv - sun).lengthSquared() < sqr(0.005f))
+                    value += 1e5f;
+                data[size_t(y) * m_resolution.x() + x] = value;
+            }
+        }
+        return ScalarImage(data, m_resolution);
+    }
+
+public:
+    DistributionBenchmark(const Properties &properties) {
+        m_resolution.x() = properties.get<int>("width", 1024);
+        m_resolution.y() = properties.get<int>("height", m_resolution.x() / 2);
+        m_samples = properties.get<int>("samples", 1 << 22);
+    }
+
+    void execute() override {
+        ScalarImage image = generateImage();
+
+        Timer buildTimer;
+        const Distribution2D distribution(image);
+        const float buildTime = buildTimer.getElapsedTime();
+        const AliasTable aliasTable(image.data());
+
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> uniform(0, 1);
+        std::vector<Point2> randoms(m_samples);
+        for (auto &u : randoms)
+            u = Point2(std::min(uniform(rng), OneMinusEpsilon), std::min(uniform(rng), OneMinusEpsilon));
+
+        // the checksums keep the compiler from optimizing the sampling away
+        float checksum = 0;
+        Timer binaryTimer;
+        for (const Point2 &u : randoms) {
+            const auto row = sampleBinarySearch(distribution.marginal(), u.y());
+            const auto column = sampleBinarySearch(distribution.conditional(row.index), u.x());
+            checksum += column.u + row.u + row.pdf * column.pdf;
+        }
+        const float binaryTime = binaryTimer.getElapsedTime();
+
+        float guideChecksum = 0;
+        Timer guideTimer;
+        for (const Point2 &u : randoms) {
+            const auto sample = distribution.sampleContinous(u);
+            guideChecksum += sample.uv.x() + sample.uv.y() + sample.pdf;
+        }
+        const float guideTime = guideTimer.getElapsedTime();
+
+        float aliasChecksum = 0;
+        Timer aliasTimer;
+        for (const Point2 &u : randoms) {
+            const auto sample = aliasTable.sample(u.x());
+            aliasChecksum += float(sample.index % m_resolution.x()) + sample.u + sample.pdf;
+        }
+        const float aliasTime = aliasTimer.getElapsedTime();
+
+        const auto throughput = [&](float time) { return time > 0 ? 1e-6f * m_samples / time : Infinity; };
+        logger(EInfo,
+               "%s: %dx%d, built in %.1f ms, binary search %.2f, guide table %.2f, alias table %.2f M samples/s "
+               "(checksums %f %f %f)",
+               id(),
+               m_resolution.x(),
+               m_resolution.y(),
+               buildTime * 1000,
+               throughput(binaryTime),
+               throughput(guideTime),
+               throughput(aliasTime),
+               checksum,
+               guideChecksum,
+               aliasChecksum);
+
+        for (const Point2 &u : randoms) {
+            const auto row = sampleBinarySearch(distribution.marginal(), u.y());
+            const auto column = sampleBinarySearch(distribution.conditional(row.index), u.x());
+            const auto sample = distribution.sampleContinous(u);
+            // the pdfs may differ in the last bit, depending on how the compiler contracts the multiplications
+            const float pdf = row.pdf * column.pdf;
+            if (sample.uv != Point2(column.u, row.u) || std::abs(sample.pdf - pdf) > 1e-6f * pdf) {
+                lightwave_throw("guide table sampled (%f, %f) with pdf %f for (%f, %f), binary search (%f, %f) with "
+                                "pdf %f",
+                                sample.uv.x(),
+                                sample.uv.y(),
+                                sample.pdf,
+                                u.x(),
+                                u.y(),
+                                column.u,
+                                row.u,
+                                pdf);
+            }
+        }
+        logger(EInfo, "test passed!");
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "DistributionBenchmark[\n"
+            "  resolution = %s,\n"
+            "  samples = %d\n"
+            "]",
+            m_resolution,
+            m_samples);
+    }
+};
+
+}
+
+REGISTER_TEST(DistributionBenchmark, "distribution")
@@ -0,0 +1,81 @@
+#include <lightwave.hpp>
+
+namespace lightwave {
+
+/**
+ * @brief Measures how fast a sampler generates random numbers, and checks that they are uniformly distributed.
+ * 
+ * The sampler is driven like a sampling integrator drives it: it is seeded for each sample of each pixel of a tile,
+ * and then queried for a fixed number of dimensions. The throughput is reported in nanoseconds per dimension.
+ * 
+ * @note Uniformity is checked through the mean of each dimension, which catches samplers that produce numbers outside
+ * of [0,1) or correlate dimensions badly, but is no substitute for looking at rendered images.
+ */
+class SamplerBenchmark : public Test {
+    /// @brief The sampler to benchmark.
+    ref<Sampler> m_sampler;
+    /// @brief The edge length of the tile of pixels that is sampled.
+    int m_resolution;
+    /// @brief The number of dimensions queried per sample.
+    int m_dimensions;
+    /// @brief The maximum deviation of the mean of a dimension from 0.5 that is tolerated.
+    float m_tolerance;
+
+public:
+    SamplerBenchmark(const Properties &properties) {
+        m_sampler = properties.getChild<Sampler>();
+        m_resolution = properties.get<int>("resolution", 64);
+        m_dimensions = properties.get<int>("dimensions", 32);
+        m_tolerance = properties.get<float>("tolerance", 5e-3f);
+    }
+
+    void execute() override {
+        const int spp = m_sampler->samplesPerPixel();
+        std::vector<double> sums(m_dimensions, 0);
+        float checksum = 0;
+        float minimum = 1, maximum = 0;
+
+        auto sampler = m_sampler->clone();
+        Timer timer;
+        for (auto pixel : Bounds2i(Point2i(0), Point2i(m_resolution))) {
+            for (int sample = 0; sample < spp; sample++) {
+                sampler->seed(pixel, sample);
+                for (int dimension = 0; dimension < m_dimensions; dimension++) {
+                    const float value = sampler->next();
+                    sums[dimension] += value;
+                    minimum = std::min(minimum, value);
+                    maximum = std::max(maximum, value);
+                    checksum += value;
+                }
+            }
+        }
+        const float elapsed = timer.getElapsedTime();
+
+        const double count = double(m_resolution) * m_resolution * spp;
+        logger(EInfo, "%s: %.2f ns per dimension (%.2f ns per sample, checksum %f)", id(),
+               1e9 * elapsed / (count * m_dimensions), 1e9 * elapsed / count, checksum);
+
+        if (minimum < 0 || maximum >= 1) {
+            lightwave_throw("sampler produced numbers outside of [0,1): [%f, %f]", minimum, maximum);
+        }
+        for (int dimension = 0; dimension < m_dimensions; dimension++) {
+            const double mean = sums[dimension] / count;
+            if (std::abs(mean - 0.5) > m_tolerance) {
+                lightwave_throw("mean of dimension %d is %f, expected 0.5", dimension, mean);
+            }
+        }
+        logger(EInfo, "test passed!");
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "SamplerBenchmark[\n"
+            "  sampler = %s\n"
+            "]",
+            indent(m_sampler));
+    }
+};
+
+}
+
+REGISTER_TEST(SamplerBenchmark, "sampler")
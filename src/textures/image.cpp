@@ -1,8 +1,12 @@
 #include "lightwave/image.hpp"
+#include "lightwave/parallel.hpp"
 #include "lightwave/properties.hpp"
 #include "lightwave/registry.hpp"
 #include "lightwave/texture.hpp"
 
+#include <bit>
+#include <ranges>
+
 namespace lightwave {
 
 class ImageTexture final : public Texture {
@@ -125,18 +129,38 @@ public:
     }
 
     ScalarImage scalar() const override {
-        Point2i resolution = m_image->resolution();
-        size_t width = resolution.x(), height = resolution.y();
-        std::vector<float> data(width * height);
-        for (size_t v = 0; v < height; v++) {
-            float sinTheta = std::sin(Pi * (v + 0.5) / height);
-            for (size_t u = 0; u < width; u++) {
-                Point2 uv(float(u) / width, 1 - float(v) / height);
-                float c = sinTheta * evaluate(uv).luminance();
-                data[v * width + u] = c;
+        // reads the pixels directly instead of going through evaluate, but filters them as evaluate does at the
+        // corners of the pixels (i.e., bilinear filtering averages the four pixels around each corner)
+        const Point2i resolution = m_image->resolution();
+        const int width = resolution.x(), height = resolution.y();
+        const auto luminance = [&](int x, int y) {
+            if (m_border == BorderMode::Clamp) {
+                x = std::clamp(x, 0, width - 1);
+                y = std::clamp(y, 0, height - 1);
+            } else {
+                x = (x + width) % width;
+                y = (y + height) % height;
             }
-        }
-        return ScalarImage(data, resolution);
+            return m_image->get(Point2i(x, y)).luminance();
+        };
+
+        std::vector<float> data(size_t(width) * height);
+        for_each_parallel(std::views::iota(0, height), [&](int v) {
+            const float sinTheta = std::sin(Pi * (v + 0.5) / height);
+            for (int u = 0; u < width; u++) {
+                float value = luminance(u, v);
+                if (m_filter == FilterMode::Bilinear)
+                    value = (value + luminance(u - 1, v - 1) + luminance(u - 1, v) + luminance(u, v - 1)) / 4;
+                data[size_t(v) * width + u] = m_exposure * sinTheta * value;
+            }
+        });
+        return ScalarImage(std::move(data), resolution);
+    }
+
+    uint64_t hash() const override {
+        uint64_t hash = hashMix(m_image->hash(), std::bit_cast<uint32_t>(m_exposure));
+        hash = hashMix(hash, uint64_t(m_border));
+        return hashMix(hash, uint64_t(m_filter));
     }
 
     std::string toString() const override {
@@ -0,0 +1,71 @@
+/**
+ * @file merge.cpp
+ * @brief Merges the partial renders of a distributed render (see the @c --partial option of lightwave) into a single
+ * image. Each partial render may cover any region of the image and any range of samples; pixels are weighted by the
+ * number of samples every partial render took for them.
+ */
+
+#include <lightwave/film.hpp>
+#include <lightwave/image.hpp>
+#include <lightwave/logger.hpp>
+
+using namespace lightwave;
+
+int main(int argc, const char *argv[]) {
+    if (argc < 3) {
+        logger(EInfo, "usage: %s <output.exr> <partial>... [--sample-count <samples.exr>]", argv[0]);
+        return -1;
+    }
+
+    try {
+        const std::filesystem::path outputPath = argv[1];
+        std::filesystem::path sampleCountPath;
+        std::vector<std::filesystem::path> partialPaths;
+        for (int i = 2; i < argc; i++) {
+            const std::string arg = argv[i];
+            if (arg == "--sample-count" && i + 1 < argc) {
+                sampleCountPath = argv[++i];
+            } else {
+                partialPaths.push_back(arg);
+            }
+        }
+
+        Film merged;
+        for (const auto &path : partialPaths) {
+            Film partial;
+            partial.load(path);
+            if (&path == &partialPaths.front()) {
+                merged = std::move(partial);
+            } else if (partial.resolution() != merged.resolution()) {
+                lightwave_throw("resolution of %s does not match the other partial renders", path);
+            } else {
+                merged.merge(partial);
+            }
+            logger(EInfo, "merged %s", path);
+        }
+
+        int64_t missingPixels = 0;
+        for (auto pixel : merged.bounds())
+            missingPixels += merged(pixel).count == 0;
+        if (missingPixels) {
+            logger(EWarn, "%ld pixels have not been covered by any partial render", missingPixels);
+        }
+
+        Image image;
+        image.initialize(merged.resolution());
+        merged.develop(image);
+        image.saveAt(outputPath);
+        logger(EInfo, "merged %ld samples into %s", merged.totalSamples(), outputPath);
+
+        if (!sampleCountPath.empty()) {
+            Image sampleCount;
+            merged.developSampleCount(sampleCount);
+            sampleCount.saveAt(sampleCountPath);
+        }
+    } catch (const std::exception &e) {
+        logger(EError, "%s", e.what());
+        return 1;
+    }
+
+    return 0;
+}